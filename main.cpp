@@ -1,11 +1,61 @@
 #include <QApplication>
+#include <QGLFormat>
 #include "mainwindow.h"
+#include "glwidget.h"
+#include "benchmark.h"
+#include "options.h"
+#include "softrunner.h"
+#include "sweeprunner.h"
+#include "gridcheck.h"
+#include "softcompare.h"
+#include "glresources.h"
+#include <string.h>
 
 int main(int argc, char *argv[])
 {
+    // the software renderer and the grid check run on machines without a
+    // display, so they must not create a QApplication
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--software") || !strcmp(argv[i], "--check-grid")) {
+            QCoreApplication a(argc, argv);
+            Options options;
+            options.parse(a);
+            if (!options.grid().isValid()) return 2;
+            return options.check_grid ? runGridCheck(options) : runSoftwareRenderer(options);
+        }
+    }
+
     QApplication a(argc, argv);
-    MainWindow w;
-    w.showMaximized(); 
+    Options options;
+    options.parse(a);
+    if (!options.grid().isValid()) return 2;
+
+    int status;
+    if (options.compare_software) {
+        status = runSoftwareComparison(options);
+    } else if (!options.sweep_path.isEmpty()) {
+        status = runParameterSweep(options);
+    } else if (!options.benchmark_path.isEmpty()) {
+        Benchmark bench;
+        if (!bench.load(options.benchmark_path)) return 2;
+
+        // measure rendering, not the display refresh rate
+        QGLFormat format = QGLFormat::defaultFormat();
+        format.setSwapInterval(0);
+        QGLFormat::setDefaultFormat(format);
+
+        GLWidget view(options);
+        view.setBenchmark(&bench);
+        view.resize(bench.width(), bench.height());
+        view.show();
+        status = a.exec();
+    } else {
+        MainWindow w(options);
+        w.showMaximized(); 
+        status = a.exec();
+    }
 
-    return a.exec();
+    // every GL object has been deleted along with its window by now
+    GLResources::reportLeaks();
+    return status;
 }
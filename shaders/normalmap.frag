@@ -0,0 +1,35 @@
+uniform float waves[300];
+uniform float texel; // uv size of one texel of the mipmap level being rendered
+
+void calc_normal(in vec2 uv, out vec3 N)
+{
+    float PI = 3.14159265358979323846264;
+    N = vec3(0.0, 0.0, 1.0);
+    for (int i = 0; i < 300; i += 6) {
+        // sorted longest first; fade out between four and two texels, so
+        // each mipmap level only sums the waves it can show
+        float lod = clamp(waves[i] / texel * 0.5 - 1.0, 0.0, 1.0);
+        if (lod <= 0.0) break;
+        float A = waves[i] * waves[i+3];         // Amplitude
+        float omega = 2.0 * PI / waves[i];       // Frequency
+        float phi = waves[i+2];                  // Phase
+        float k = waves[i+1];
+        float term = omega * dot(vec2(waves[i+4], waves[i+5]), uv) + phi;
+        float C = cos(term);
+        float S = sin(term);
+        float val = pow(0.5 * (S + 1.0), k - 1.0) * C;
+        val = omega * A * k * val * lod;
+        N += vec3(waves[i+4] * val,
+                  waves[i+5] * val,
+                  0.0);
+    }
+    N = normalize(N);
+}
+
+void main(void)
+{
+    vec3 N;
+    calc_normal(gl_FragCoord.st * texel, N);
+    N = (N * 0.5) + 0.5;
+    gl_FragColor = vec4(N.xyz, 1.0);
+}
@@ -0,0 +1,84 @@
+// Waves are sorted longest first. Each one fades out between four and two
+// pixels per wavelength at this vertex and the loops end at the first that
+// is gone, so distant vertices sum fewer waves.
+float wave_lod(in float wavelength, in float pixel)
+{
+    return clamp(wavelength / pixel * 0.5 - 1.0, 0.0, 1.0);
+}
+
+void wave_function(in float waves[24], in vec3 pos, in float pixel,
+                   out vec3 P, out vec3 N, out vec3 B, out vec3 T)
+{
+    float PI = 3.14159265358979323846264;
+    P = pos;
+    for (int i = 0; i < 24; i += 6) {
+        float lod = wave_lod(waves[i], pixel);
+        if (lod <= 0.0) break;
+        float A = waves[i] * waves[i+3];         // Amplitude
+        float omega = 2.0 * PI / waves[i];       // Frequency
+        float phi = waves[i+2];                  // Phase
+        float Qi = waves[i+1]/(omega * A * 4.0); // Steepness
+
+        float term = omega * dot(vec2(waves[i+4], waves[i+5]), vec2(pos.x, pos.z)) + phi;
+        float C = cos(term);
+        float S = sin(term);
+        P += lod * vec3(Qi * A * waves[i+4] * C,
+                        A * S,
+                        Qi * A * waves[i+5] * C);
+    }
+    B = vec3(0.0);
+    T = vec3(0.0);
+    N = vec3(0.0);
+    for (int i = 0; i < 24; i += 6) {
+        float lod = wave_lod(waves[i], pixel);
+        if (lod <= 0.0) break;
+        float A = waves[i] * waves[i+3];         // Amplitude
+        float omega = 2.0 * PI / waves[i];       // Frequency
+        float phi = waves[i+2];                  // Phase
+        float Qi = waves[i+1]/(omega * A * 4.0); // Steepness
+
+        float WA = omega * A * lod;
+        float term = omega * dot(vec2(waves[i+4], waves[i+5]), vec2(P.x, P.z)) + phi;
+        float C = cos(term)/6.0;
+        float S = sin(term);
+        B += vec3 (Qi * waves[i+4]*waves[i+4] * WA * S,
+                   Qi * waves[i+4] * waves[i+5] * WA * S,
+                   waves[i+4] * WA * C);
+
+        T += vec3 (Qi * waves[i+4] * waves[i+5] * WA * S,
+                   Qi * waves[i+5] * waves[i+5] * WA * S,
+                   waves[i+5] * WA * C);
+
+        N += vec3 (waves[i+4] * WA * C,
+                   waves[i+5] * WA * C,
+                   Qi * WA * S);
+    }
+    B = normalize(vec3(1.0 - B.x, -B.y, B.z));
+    T = normalize(vec3(-T.x, 1.0 - T.y, T.z));
+    N = normalize(vec3(-N.x, -N.y, 1.0 - N.z));
+}
+
+uniform float waves[24];
+uniform vec3 light;
+uniform float footprint; // size of a pixel at unit view depth
+
+varying vec2 texcoord;
+varying vec3 lightv;
+varying vec3 viewv;
+void main(void)
+{
+    vec3 P, N, B, T;
+    float depth = -(gl_ModelViewMatrix * gl_Vertex).z;
+    wave_function(waves, gl_Vertex.xyz, footprint * max(depth, 0.001), P, N, B, T);
+    lightv = vec3(dot(light, B),
+                  dot(light, T),
+                  dot(light, N));
+    lightv = normalize(lightv);
+    vec3 pos = (gl_ModelViewMatrix * vec4(P.xyz, 1.0)).xyz;
+    viewv = vec3(dot(pos, B),
+                 dot(pos, T),
+                 dot(pos, N));
+    viewv = normalize(viewv);
+    texcoord = vec2(P.x, P.z) * 0.5 + 0.5;
+    gl_Position = gl_ProjectionMatrix * vec4(pos, 1.0);
+}
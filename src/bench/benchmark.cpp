@@ -0,0 +1,230 @@
+#include "benchmark.h"
+#include "parametersweep.h"
+#include "gputimer.h"
+#include "camera.h"
+#include "glresources.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QStringList>
+#include <qgl.h>
+#include <algorithm>
+#include <iostream>
+
+Benchmark::Benchmark()
+{
+    m_seed = 1;
+    m_frames = 600;
+    m_warmup = 30;
+    m_width = 1280;
+    m_height = 720;
+    m_dt = 1.f/60.f;
+    m_has_params = false;
+    m_params = WaveSet::defaultParameters();
+    m_frame = 0;
+    m_gpu = NULL;
+}
+
+Benchmark::~Benchmark()
+{
+    delete m_gpu;
+}
+
+bool Benchmark::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cout << "error: Cannot open benchmark " << qPrintable(path) << std::endl;
+        return false;
+    }
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!doc.isObject()) {
+        std::cout << "error: " << qPrintable(path) << ": " << qPrintable(error.errorString()) << std::endl;
+        return false;
+    }
+
+    QJsonObject o = doc.object();
+    m_path = path;
+    m_camera.fromJson(o.value("camera").toArray());
+    if (m_camera.isEmpty()) {
+        std::cout << "error: " << qPrintable(path) << " has no camera path" << std::endl;
+        return false;
+    }
+
+    m_seed = o.value("seed").toInt(m_seed);
+    m_dt = o.value("dt").toDouble(m_dt);
+    m_frames = o.value("frames").toInt((int)(m_camera.duration() / m_dt) + 1);
+    m_warmup = o.value("warmup").toInt(m_warmup);
+    m_width = o.value("width").toInt(m_width);
+    m_height = o.value("height").toInt(m_height);
+    m_budget = o.value("budget").toObject();
+
+    if (o.value("parameters").isObject()) {
+        m_has_params = true;
+        m_params = parametersFromJson(o.value("parameters").toObject(), m_params);
+    }
+
+    if (m_frames <= 0 || m_dt <= 0.f || m_width <= 0 || m_height <= 0) {
+        std::cout << "error: " << qPrintable(path) << " has an invalid frame setup" << std::endl;
+        return false;
+    }
+
+    m_cpu_ms.fill(0.0, m_frames);
+    m_gpu_ms.fill(-1.0, m_frames);
+    m_frame_ms.fill(0.0, m_frames);
+    return true;
+}
+
+void Benchmark::setCpuOnly(const QString &renderer)
+{
+    m_renderer = renderer;
+}
+
+void Benchmark::beginFrame(Camera *camera)
+{
+    bool gpu = m_renderer.isEmpty();
+    if (gpu && !m_gpu) m_gpu = new GpuTimer();
+
+    // whole-frame time runs from one frame start to the next, so it includes
+    // the buffer swap of the previous frame
+    int index = m_frame - m_warmup;
+    if (index > 0) m_frame_ms[index - 1] = m_frame_timer.nsecsElapsed() * 1e-6;
+    m_frame_timer.start();
+
+    m_camera.apply(time(), camera);
+
+    if (gpu) {
+        collectGpu(false);
+        if (m_gpu->isFull()) collectGpu(true);
+        m_gpu->begin(index);
+    }
+    m_cpu_timer.start();
+}
+
+void Benchmark::endFrame()
+{
+    qint64 cpu = m_cpu_timer.nsecsElapsed();
+    if (m_gpu) m_gpu->end();
+
+    int index = m_frame - m_warmup;
+    if (index >= 0) m_cpu_ms[index] = cpu * 1e-6;
+    m_frame++;
+}
+
+void Benchmark::releaseGpu()
+{
+    delete m_gpu;
+    m_gpu = NULL;
+}
+
+void Benchmark::collectGpu(bool wait)
+{
+    int tag;
+    qint64 ns;
+    while (m_gpu->takeResult(&tag, &ns, wait)) {
+        if (tag >= 0 && tag < m_frames) m_gpu_ms[tag] = ns * 1e-6;
+        wait = false;
+    }
+}
+
+Benchmark::Stats Benchmark::statistics(QVector<double> ms)
+{
+    Stats s;
+    s.mean = s.p50 = s.p95 = s.p99 = s.worst = 0.0;
+    if (ms.isEmpty()) return s;
+
+    std::sort(ms.begin(), ms.end());
+    double sum = 0.0;
+    for (int i = 0; i < ms.size(); i++) sum += ms[i];
+    s.mean = sum / ms.size();
+
+    // nearest rank
+    int n = ms.size();
+    s.p50 = ms[qMax(0, (int)ceil(0.50 * n) - 1)];
+    s.p95 = ms[qMax(0, (int)ceil(0.95 * n) - 1)];
+    s.p99 = ms[qMax(0, (int)ceil(0.99 * n) - 1)];
+    s.worst = ms[n - 1];
+    return s;
+}
+
+QJsonObject Benchmark::toJson(const Stats &s)
+{
+    QJsonObject o;
+    o.insert("mean", s.mean);
+    o.insert("p50", s.p50);
+    o.insert("p95", s.p95);
+    o.insert("p99", s.p99);
+    o.insert("worst", s.worst);
+    return o;
+}
+
+void Benchmark::checkBudget(const QString &name, const Stats &s, QStringList &violations) const
+{
+    QJsonObject limits = m_budget.value(name).toObject();
+    const char *keys[] = { "mean", "p50", "p95", "p99", "worst" };
+    double values[] = { s.mean, s.p50, s.p95, s.p99, s.worst };
+    for (int i = 0; i < 5; i++) {
+        if (!limits.contains(keys[i])) continue;
+        double limit = limits.value(keys[i]).toDouble();
+        if (values[i] > limit)
+            violations.append(QString("%1.%2 %3 ms > %4 ms").arg(name).arg(keys[i])
+                              .arg(values[i], 0, 'f', 3).arg(limit, 0, 'f', 3));
+    }
+}
+
+int Benchmark::finish(const QString &report_path)
+{
+    // the last frame's whole-frame time ends here; then drain the GPU timings
+    if (m_frames > 0) m_frame_ms[m_frames - 1] = m_frame_timer.nsecsElapsed() * 1e-6;
+    int tag;
+    qint64 ns;
+    while (m_gpu && m_gpu->takeResult(&tag, &ns, true))
+        if (tag >= 0 && tag < m_frames) m_gpu_ms[tag] = ns * 1e-6;
+    releaseGpu();
+
+    QVector<double> gpu;
+    for (int i = 0; i < m_gpu_ms.size(); i++)
+        if (m_gpu_ms[i] >= 0.0) gpu.append(m_gpu_ms[i]);
+
+    Stats cpu_stats = statistics(m_cpu_ms);
+    Stats gpu_stats = statistics(gpu);
+    Stats frame_stats = statistics(m_frame_ms);
+
+    QStringList violations;
+    checkBudget("cpu", cpu_stats, violations);
+    checkBudget("gpu", gpu_stats, violations);
+    checkBudget("frame", frame_stats, violations);
+
+    QJsonObject report;
+    report.insert("benchmark", m_path);
+    if (m_renderer.isEmpty()) {
+        report.insert("renderer", QString((const char *)glGetString(GL_RENDERER)));
+        report.insert("version", QString((const char *)glGetString(GL_VERSION)));
+    } else {
+        report.insert("renderer", m_renderer);
+    }
+    report.insert("frames", m_frames);
+    report.insert("gpu_frames", gpu.size());
+    report.insert("seed", (int)m_seed);
+    report.insert("dt", m_dt);
+    report.insert("cpu_ms", toJson(cpu_stats));
+    report.insert("gpu_ms", toJson(gpu_stats));
+    report.insert("frame_ms", toJson(frame_stats));
+    if (m_renderer.isEmpty()) report.insert("gl_memory", GLResources::report());
+    report.insert("budget", m_budget);
+    QJsonArray v;
+    for (int i = 0; i < violations.size(); i++) v.append(violations[i]);
+    report.insert("violations", v);
+    report.insert("passed", violations.isEmpty());
+
+    QByteArray json = QJsonDocument(report).toJson();
+    std::cout << json.constData() << std::flush;
+    if (!report_path.isEmpty()) {
+        QFile file(report_path);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) file.write(json);
+        else std::cout << "error: Cannot write " << qPrintable(report_path) << std::endl;
+    }
+
+    return violations.isEmpty() ? 0 : 1;
+}
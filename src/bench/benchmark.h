@@ -0,0 +1,87 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <QElapsedTimer>
+
+#include "camerapath.h"
+#include "waveset.h"
+
+class Camera;
+class GpuTimer;
+
+// Plays back a camera path with fixed wave seeds and simulated time and
+// gathers CPU, GPU and whole-frame times. A benchmark file looks like
+//
+//   { "seed": 1, "frames": 600, "warmup": 30, "dt": 0.0166667,
+//     "width": 1280, "height": 720,
+//     "parameters": { "wavelength": 10, "steepness": 0.8, "speed": 0.15, "amplitude": 0.02 },
+//     "camera": [ { "time": 0, "zoom": 60, "hangle": 0, "vangle": 0.39, "center": [0, 0, 0] }, ... ],
+//     "budget": { "frame": { "p95": 16.7 }, "gpu": { "p99": 8, "worst": 20 } } }
+//
+// Everything but "camera" is optional. A file written by --record-camera is
+// a valid benchmark. Budgets are in milliseconds and may name mean, p50, p95,
+// p99 or worst for each of cpu, gpu and frame.
+class Benchmark
+{
+public:
+    Benchmark();
+    ~Benchmark();
+
+    bool load(const QString &path);
+
+    // for renderers without a GL context: no GPU timings, and the report
+    // names renderer instead of GL_RENDERER
+    void setCpuOnly(const QString &renderer);
+
+    inline unsigned int seed() const { return m_seed; }
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+    inline bool hasParameters() const { return m_has_params; }
+    inline const WaveParameters &parameters() const { return m_params; }
+
+    inline bool isDone() const { return m_frame >= m_warmup + m_frames; }
+    inline float time() const { return m_frame * m_dt; }
+
+    // bracket the rendering of one frame, with the GL context current
+    void beginFrame(Camera *camera);
+    void endFrame();
+
+    // prints the report as JSON (and writes it to report_path if set) and
+    // returns the process exit code: 0 within budget, 1 over budget
+    int finish(const QString &report_path);
+
+    // deletes the GPU timer queries, with the GL context current. finish()
+    // does this; a run cut short must call it before the context goes.
+    void releaseGpu();
+
+private:
+    struct Stats
+    {
+        double mean, p50, p95, p99, worst;
+    };
+
+    static Stats statistics(QVector<double> ms);
+    static QJsonObject toJson(const Stats &s);
+    void checkBudget(const QString &name, const Stats &s, QStringList &violations) const;
+    void collectGpu(bool wait);
+
+    QString m_path;
+    unsigned int m_seed;
+    int m_frames, m_warmup, m_width, m_height;
+    float m_dt;
+    bool m_has_params;
+    WaveParameters m_params;
+    CameraPath m_camera;
+    QJsonObject m_budget;
+
+    int m_frame;
+    QString m_renderer;
+    GpuTimer *m_gpu;
+    QElapsedTimer m_cpu_timer, m_frame_timer;
+    QVector<double> m_cpu_ms, m_gpu_ms, m_frame_ms;
+};
+
+#endif // BENCHMARK_H
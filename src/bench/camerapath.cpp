@@ -0,0 +1,85 @@
+#include "camerapath.h"
+#include "camera.h"
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QFile>
+
+void CameraPath::fromJson(const QJsonArray &keys)
+{
+    m_keys.clear();
+    for (int i = 0; i < keys.size(); i++) {
+        QJsonObject o = keys.at(i).toObject();
+        QJsonArray c = o.value("center").toArray();
+        Key k;
+        k.time = o.value("time").toDouble();
+        k.zoom = o.value("zoom").toDouble(60.0);
+        k.hangle = o.value("hangle").toDouble();
+        k.vangle = o.value("vangle").toDouble(M_PI_4*0.5);
+        k.center = Vector3(c.at(0).toDouble(), c.at(1).toDouble(), c.at(2).toDouble());
+        // keyframes must be ordered; drop any that go back in time
+        if (m_keys.isEmpty() || k.time >= m_keys.last().time) m_keys.append(k);
+    }
+}
+
+QJsonArray CameraPath::toJson() const
+{
+    QJsonArray keys;
+    for (int i = 0; i < m_keys.size(); i++) {
+        const Key &k = m_keys[i];
+        QJsonArray c;
+        c.append(k.center.x);
+        c.append(k.center.y);
+        c.append(k.center.z);
+        QJsonObject o;
+        o.insert("time", k.time);
+        o.insert("zoom", k.zoom);
+        o.insert("hangle", k.hangle);
+        o.insert("vangle", k.vangle);
+        o.insert("center", c);
+        keys.append(o);
+    }
+    return keys;
+}
+
+bool CameraPath::save(const QString &path) const
+{
+    QJsonObject o;
+    o.insert("camera", toJson());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return false;
+    file.write(QJsonDocument(o).toJson());
+    return true;
+}
+
+void CameraPath::record(float time, const Camera *camera)
+{
+    Key k;
+    k.time = time;
+    k.zoom = camera->zoomValue();
+    k.hangle = camera->horizontalAngle();
+    k.vangle = camera->verticalAngle();
+    k.center = camera->center();
+    m_keys.append(k);
+}
+
+void CameraPath::apply(float time, Camera *camera) const
+{
+    if (m_keys.isEmpty()) return;
+
+    // last keyframe at or before time
+    int i = 0, hi = m_keys.size() - 1;
+    while (i < hi) {
+        int mid = (i + hi + 1) / 2;
+        if (m_keys[mid].time <= time) i = mid;
+        else hi = mid - 1;
+    }
+    const Key &a = m_keys[i];
+    const Key &b = m_keys[i + 1 < m_keys.size() ? i + 1 : i];
+
+    float t = b.time > a.time ? (time - a.time) / (b.time - a.time) : 0.f;
+    t = fminf(fmaxf(t, 0.f), 1.f);
+    camera->setZoom(a.zoom + (b.zoom - a.zoom) * t);
+    camera->setAngles(a.hangle + (b.hangle - a.hangle) * t,
+                      a.vangle + (b.vangle - a.vangle) * t);
+    camera->setCenter(Vector3::lerp(a.center, b.center, t));
+}
@@ -0,0 +1,39 @@
+#ifndef CAMERAPATH_H
+#define CAMERAPATH_H
+
+#include <QVector>
+#include <QJsonArray>
+#include "vector.h"
+
+class Camera;
+
+// Camera keyframes over time, either scripted in a benchmark file or recorded
+// from an interactive session. Stored as a JSON array of
+// { "time", "zoom", "hangle", "vangle", "center": [x, y, z] } objects.
+class CameraPath
+{
+public:
+    void fromJson(const QJsonArray &keys);
+    QJsonArray toJson() const;
+    bool save(const QString &path) const;
+
+    void record(float time, const Camera *camera);
+    // places the camera at the linearly interpolated keyframe for time
+    void apply(float time, Camera *camera) const;
+
+    inline bool isEmpty() const { return m_keys.isEmpty(); }
+    inline float duration() const { return m_keys.isEmpty() ? 0.f : m_keys.last().time; }
+
+private:
+    struct Key
+    {
+        float time;
+        float zoom;
+        float hangle, vangle;
+        Vector3 center;
+    };
+
+    QVector<Key> m_keys;
+};
+
+#endif // CAMERAPATH_H
@@ -0,0 +1,62 @@
+#include "gputimer.h"
+#include "glresources.h"
+
+#ifndef __APPLE__
+extern "C"
+{
+    void glGenQueries (GLsizei, GLuint *);
+    void glDeleteQueries (GLsizei, const GLuint *);
+    void glBeginQuery (GLenum, GLuint);
+    void glEndQuery (GLenum);
+    void glGetQueryObjectiv (GLuint, GLenum, GLint *);
+    void glGetQueryObjectui64v (GLuint, GLenum, GLuint64 *);
+}
+#endif
+
+GpuTimer::GpuTimer()
+{
+    glGenQueries(GPU_TIMER_QUERIES, m_queries);
+    for (int i = 0; i < GPU_TIMER_QUERIES; i++)
+        GLResources::add(GLResources::Query, m_queries[i], 0, "gpu timer");
+    m_oldest = m_pending = 0;
+}
+
+GpuTimer::~GpuTimer()
+{
+    for (int i = 0; i < GPU_TIMER_QUERIES; i++)
+        GLResources::remove(GLResources::Query, m_queries[i]);
+    glDeleteQueries(GPU_TIMER_QUERIES, m_queries);
+}
+
+void GpuTimer::begin(int tag)
+{
+    int slot = (m_oldest + m_pending) % GPU_TIMER_QUERIES;
+    m_tags[slot] = tag;
+    glBeginQuery(GL_TIME_ELAPSED, m_queries[slot]);
+}
+
+void GpuTimer::end()
+{
+    glEndQuery(GL_TIME_ELAPSED);
+    m_pending++;
+}
+
+bool GpuTimer::takeResult(int *tag, qint64 *nanoseconds, bool wait)
+{
+    if (m_pending == 0) return false;
+
+    GLuint query = m_queries[m_oldest];
+    if (!wait) {
+        GLint available = 0;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+    *tag = m_tags[m_oldest];
+    *nanoseconds = (qint64)result;
+    m_oldest = (m_oldest + 1) % GPU_TIMER_QUERIES;
+    m_pending--;
+    return true;
+}
@@ -0,0 +1,32 @@
+#ifndef GPUTIMER_H
+#define GPUTIMER_H
+
+#include <qgl.h>
+
+// Number of GL_TIME_ELAPSED queries in flight before begin() has to wait
+#define GPU_TIMER_QUERIES 8
+
+// Measures GPU time per frame with a ring of timer queries whose results are
+// collected several frames later, so timing does not serialize CPU and GPU.
+// All methods must be called with the same GL context current.
+class GpuTimer
+{
+public:
+    GpuTimer();
+    ~GpuTimer();
+
+    // begin() must not be called while isFull(); collect with takeResult() first
+    void begin(int tag);
+    void end();
+    inline bool isFull() const { return m_pending == GPU_TIMER_QUERIES; }
+
+    // oldest finished measurement; with wait set, blocks until it is available
+    bool takeResult(int *tag, qint64 *nanoseconds, bool wait);
+
+private:
+    GLuint m_queries[GPU_TIMER_QUERIES];
+    int m_tags[GPU_TIMER_QUERIES];
+    int m_oldest, m_pending;
+};
+
+#endif // GPUTIMER_H
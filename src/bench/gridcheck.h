@@ -0,0 +1,12 @@
+#ifndef GRIDCHECK_H
+#define GRIDCHECK_H
+
+struct Options;
+
+// Compares gerstnerDisplaceGrid() against gerstnerDisplace() at every point
+// of the --heights-region / --heights-resolution grid for a range of seeds.
+// Prints the errors and timings as JSON and returns 0 if the largest error
+// is within tolerance, 1 if not. Needs no display and no GL context.
+int runGridCheck(const Options &options);
+
+#endif // GRIDCHECK_H
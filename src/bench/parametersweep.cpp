@@ -0,0 +1,121 @@
+#include "parametersweep.h"
+#include "camera.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <iostream>
+
+static const char *keys[] = { "wavelength", "steepness", "speed", "amplitude" };
+
+static float *field(WaveParameters &p, int key)
+{
+    float *fields[] = { &p.wavelength, &p.steepness, &p.speed, &p.kAmpOverLen };
+    return fields[key];
+}
+
+WaveParameters parametersFromJson(const QJsonObject &o, const WaveParameters &defaults)
+{
+    WaveParameters p = defaults;
+    for (int i = 0; i < 4; i++) *field(p, i) = o.value(keys[i]).toDouble(*field(p, i));
+    return p;
+}
+
+QJsonObject parametersToJson(const WaveParameters &params)
+{
+    WaveParameters p = params;
+    QJsonObject o;
+    for (int i = 0; i < 4; i++) o.insert(keys[i], *field(p, i));
+    return o;
+}
+
+ParameterSweep::ParameterSweep()
+{
+    m_width = 320;
+    m_height = 180;
+    m_time = 0.f;
+}
+
+bool ParameterSweep::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cout << "error: Cannot open sweep " << qPrintable(path) << std::endl;
+        return false;
+    }
+    QJsonParseError error;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (!doc.isObject()) {
+        std::cout << "error: " << qPrintable(path) << ": " << qPrintable(error.errorString()) << std::endl;
+        return false;
+    }
+
+    QJsonObject o = doc.object();
+    m_width = o.value("width").toInt(m_width);
+    m_height = o.value("height").toInt(m_height);
+    m_time = o.value("time").toDouble(m_time);
+    if (o.value("camera").isObject()) {
+        QJsonArray keys;
+        keys.append(o.value("camera"));
+        m_camera.fromJson(keys);
+    }
+    if (m_width <= 0 || m_height <= 0) {
+        std::cout << "error: " << qPrintable(path) << " has an invalid image size" << std::endl;
+        return false;
+    }
+
+    // parameter sets first, then each of them with every seed
+    m_variants.clear();
+    QJsonArray list = o.value("parameters").toArray();
+    for (int i = 0; i < list.size(); i++) {
+        Variant v;
+        v.params = parametersFromJson(list[i].toObject(), WaveSet::defaultParameters());
+        m_variants.append(v);
+    }
+    if (o.value("grid").isObject()) addGrid(o.value("grid").toObject());
+    if (m_variants.isEmpty()) {
+        std::cout << "error: " << qPrintable(path) << " has no parameters or grid" << std::endl;
+        return false;
+    }
+
+    QJsonArray seeds = o.value("seeds").toArray();
+    if (seeds.isEmpty()) seeds.append(1);
+    QVector<Variant> sets = m_variants;
+    m_variants.clear();
+    for (int i = 0; i < sets.size(); i++) {
+        for (int j = 0; j < seeds.size(); j++) {
+            sets[i].seed = seeds[j].toInt();
+            m_variants.append(sets[i]);
+        }
+    }
+    return true;
+}
+
+void ParameterSweep::addGrid(const QJsonObject &grid)
+{
+    // every combination, the last key varying fastest
+    QJsonArray values[4];
+    int total = 1;
+    for (int i = 0; i < 4; i++) {
+        values[i] = grid.value(keys[i]).toArray();
+        if (!values[i].isEmpty()) total *= values[i].size();
+    }
+    for (int n = 0; n < total; n++) {
+        Variant v;
+        v.params = WaveSet::defaultParameters();
+        int rest = n;
+        for (int i = 3; i >= 0; i--) {
+            if (values[i].isEmpty()) continue;
+            *field(v.params, i) = values[i][rest % values[i].size()].toDouble();
+            rest /= values[i].size();
+        }
+        m_variants.append(v);
+    }
+}
+
+void ParameterSweep::applyCamera(Camera *camera) const
+{
+    // same view as the window starts with, unless the file sets one
+    camera->setZoom(60.f);
+    camera->setAngles(0.f, M_PI_4*0.5f);
+    if (!m_camera.isEmpty()) m_camera.apply(0.f, camera);
+}
@@ -0,0 +1,60 @@
+#ifndef PARAMETERSWEEP_H
+#define PARAMETERSWEEP_H
+
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+
+#include "camerapath.h"
+#include "waveset.h"
+
+class Camera;
+
+// "parameters" objects as in benchmark and sweep files; missing keys keep
+// the values of defaults
+WaveParameters parametersFromJson(const QJsonObject &o, const WaveParameters &defaults);
+QJsonObject parametersToJson(const WaveParameters &params);
+
+// A list of wave parameter sets, each rendered with every seed into one
+// image of the same view. A sweep file looks like
+//
+//   { "width": 320, "height": 180, "time": 2,
+//     "camera": { "zoom": 60, "hangle": 0, "vangle": 0.39, "center": [0, 0, 0] },
+//     "seeds": [1, 2, 3],
+//     "parameters": [ { "wavelength": 10, "steepness": 0.8 }, ... ],
+//     "grid": { "wavelength": [5, 10, 20], "steepness": [0.4, 0.8] } }
+//
+// "parameters" lists sets explicitly, "grid" adds every combination of the
+// listed values; keys left out of either keep their defaults. Both may be
+// given. "time" is how far the waves have moved on since they were drawn.
+class ParameterSweep
+{
+public:
+    struct Variant
+    {
+        WaveParameters params;
+        unsigned int seed;
+    };
+
+    ParameterSweep();
+
+    bool load(const QString &path);
+
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+    inline float time() const { return m_time; }
+    inline int count() const { return m_variants.size(); }
+    inline const Variant &variant(int i) const { return m_variants[i]; }
+
+    void applyCamera(Camera *camera) const;
+
+private:
+    void addGrid(const QJsonObject &grid);
+
+    int m_width, m_height;
+    float m_time;
+    CameraPath m_camera;
+    QVector<Variant> m_variants;
+};
+
+#endif // PARAMETERSWEEP_H
@@ -0,0 +1,211 @@
+#include "sweeprunner.h"
+#include "parametersweep.h"
+#include "waterengine.h"
+#include "glresources.h"
+#include "camera.h"
+#include "options.h"
+#include "offscreentarget.h"
+#include <QGLPixelBuffer>
+#include <QImage>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <iostream>
+#include <math.h>
+
+// Largest atlas edge; 4096x4096 color and depth take 128 MB
+#define ATLAS_MAX_SIZE 4096
+
+struct ImageFile
+{
+    QImage image;
+    QString path;
+    bool written;
+};
+
+static void writeImage(ImageFile &file)
+{
+    file.written = file.image.save(file.path);
+    file.image = QImage();
+}
+
+// waits for the previous page's files, false if one could not be written
+static bool finishWrites(QFuture<void> &writes, const QVector<ImageFile> &files)
+{
+    writes.waitForFinished();
+    bool ok = true;
+    for (int i = 0; i < files.size(); i++) {
+        if (files[i].written) continue;
+        std::cout << "error: Cannot write " << qPrintable(files[i].path) << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+static int renderSweep(const ParameterSweep &sweep, const GridSettings &grid, const Options &options)
+{
+    QDir dir(options.sweep_output);
+    if (!dir.mkpath(".")) {
+        std::cout << "error: Cannot create " << qPrintable(options.sweep_output) << std::endl;
+        return 2;
+    }
+
+    WaterEngine engine(options.shader_dir, grid);
+    // the first mesh is built and uploaded over a few frames
+    while (engine.isValid() && engine.gridPending()) {
+        engine.render(0.f);
+        QThread::msleep(1);
+    }
+    if (!engine.isValid()) {
+        std::cout << "error: Cannot set up the renderer" << std::endl;
+        return 2;
+    }
+
+    // as many tiles per atlas page as fit, in a roughly square layout
+    int w = sweep.width(), h = sweep.height();
+    GLint max_rb, max_vp[2];
+    glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &max_rb);
+    glGetIntegerv(GL_MAX_VIEWPORT_DIMS, max_vp);
+    int max_cols = qMin(qMin((int)max_rb, (int)max_vp[0]), ATLAS_MAX_SIZE) / w;
+    int max_rows = qMin(qMin((int)max_rb, (int)max_vp[1]), ATLAS_MAX_SIZE) / h;
+    if (max_cols < 1 || max_rows < 1) {
+        std::cout << "error: Sweep images of " << w << "x" << h << " do not fit into an atlas" << std::endl;
+        return 2;
+    }
+    int cols = qMin(max_cols, (int)ceil(sqrt((double)sweep.count())));
+    int rows = qMin(max_rows, (sweep.count() + cols - 1) / cols);
+    int per_page = cols * rows;
+
+    OffscreenTarget atlas(cols * w, rows * h, "sweep atlas");
+    if (!atlas.isValid()) return 2;
+
+    Camera camera(45.f, (float)w/(float)h, 0.1f, 1000.f);
+    sweep.applyCamera(&camera);
+    camera.loadPerspectiveMatrix();
+
+    // file names sort in sweep order
+    int digits = QString::number(sweep.count() - 1).size();
+    QJsonArray pages, variants;
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 render_ns = 0;
+    QVector<ImageFile> files;
+    QFuture<void> writes;
+    bool ok = true;
+    engine.setBlendTime(0.f);
+
+    for (int first = 0; first < sweep.count(); first += per_page) {
+        int page = first / per_page;
+        int n = qMin(per_page, sweep.count() - first);
+        QElapsedTimer page_timer;
+        page_timer.start();
+
+        // one clear for all tiles; they never overlap
+        atlas.bind();
+        glViewport(0, 0, atlas.width(), atlas.height());
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        // the mesh, programs and normal map texture stay bound to the same
+        // objects throughout, each tile only uploads its waves
+        for (int i = 0; i < n; i++) {
+            const ParameterSweep::Variant &v = sweep.variant(first + i);
+            engine.setParameters(v.params);
+            engine.randomizeWaves(v.seed);
+            engine.setWaveTime(0.f);
+
+            // tile rows run top down in the images, GL counts from the bottom
+            int col = i % cols, row = i / cols;
+            glViewport(col * w, (rows - 1 - row) * h, w, h);
+            camera.loadModelviewMatrix();
+            engine.render(sweep.time());
+        }
+
+        // a single readback per page, which also waits for the rendering
+        QImage image = atlas.read();
+        render_ns += page_timer.nsecsElapsed();
+        if (!GLResources::checkError("rendering the sweep")) {
+            ok = false;
+            break;
+        }
+
+        // the PNGs of this page are encoded while the next one renders
+        ok = finishWrites(writes, files) && ok;
+        files.clear();
+        ImageFile f;
+        f.path = dir.filePath(QString("atlas-%1.png").arg(page));
+        f.image = image;
+        files.append(f);
+
+        QJsonObject p;
+        p.insert("file", QFileInfo(f.path).fileName());
+        p.insert("columns", cols);
+        p.insert("rows", (n + cols - 1) / cols);
+        pages.append(p);
+
+        for (int i = 0; i < n; i++) {
+            int col = i % cols, row = i / cols;
+            f.path = dir.filePath(QString("variant-%1.png").arg(first + i, digits, 10, QChar('0')));
+            f.image = image.copy(col * w, row * h, w, h);
+            files.append(f);
+
+            const ParameterSweep::Variant &v = sweep.variant(first + i);
+            QJsonObject o;
+            o.insert("file", QFileInfo(f.path).fileName());
+            o.insert("seed", (double)v.seed);
+            o.insert("parameters", parametersToJson(v.params));
+            o.insert("atlas", page);
+            QJsonArray tile;
+            tile.append(col * w);
+            tile.append(row * h);
+            o.insert("tile", tile);
+            variants.append(o);
+        }
+        writes = QtConcurrent::map(files, writeImage);
+    }
+    ok = finishWrites(writes, files) && ok;
+    qint64 total_ms = timer.elapsed();
+
+    QJsonObject index;
+    index.insert("sweep", options.sweep_path);
+    index.insert("width", w);
+    index.insert("height", h);
+    index.insert("time", sweep.time());
+    index.insert("atlases", pages);
+    index.insert("variants", variants);
+    QFile file(dir.filePath("index.json"));
+    if (!file.open(QIODevice::WriteOnly) || file.write(QJsonDocument(index).toJson()) < 0) {
+        std::cout << "error: Cannot write " << qPrintable(file.fileName()) << std::endl;
+        ok = false;
+    }
+
+    std::cout << "Rendered " << sweep.count() << " variants on " << pages.size() << " atlas pages in "
+              << render_ns / 1000000 << " ms, written to " << qPrintable(options.sweep_output)
+              << " in " << total_ms << " ms" << std::endl;
+    return ok ? 0 : 1;
+}
+
+int runParameterSweep(const Options &options)
+{
+    ParameterSweep sweep;
+    if (!sweep.load(options.sweep_path)) return 2;
+
+    // main() has validated it
+    GridSettings grid = options.grid();
+
+    // the atlas is the render target, so the context needs no window
+    QGLPixelBuffer context(QSize(1, 1));
+    if (!context.isValid() || !context.makeCurrent()) {
+        std::cout << "error: Cannot create an offscreen GL context" << std::endl;
+        return 2;
+    }
+    // every GL object is gone before the context
+    int status = renderSweep(sweep, grid, options);
+    context.doneCurrent();
+    return status;
+}
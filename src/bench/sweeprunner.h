@@ -0,0 +1,12 @@
+#ifndef SWEEPRUNNER_H
+#define SWEEPRUNNER_H
+
+struct Options;
+
+// Renders every variant of the --sweep file into tiles of an offscreen
+// atlas and writes each tile, each atlas page and an index to
+// --sweep-output. Returns the process exit code. Needs a QApplication for
+// the GL context, but no window.
+int runParameterSweep(const Options &options);
+
+#endif // SWEEPRUNNER_H
@@ -0,0 +1,143 @@
+#include "framecapture.h"
+#include "frameencoder.h"
+#include "glresources.h"
+#include <iostream>
+
+#ifndef __APPLE__
+extern "C"
+{
+    void glBindBuffer (GLenum, GLuint);
+    void glDeleteBuffers (GLsizei, const GLuint *);
+    void glGenBuffers (GLsizei, GLuint *);
+    void glBufferData (GLenum, GLsizeiptr, const GLvoid *, GLenum);
+    GLvoid *glMapBuffer (GLenum, GLenum);
+    GLboolean glUnmapBuffer (GLenum);
+    GLsync glFenceSync (GLenum, GLbitfield);
+    GLenum glClientWaitSync (GLsync, GLbitfield, GLuint64);
+    void glDeleteSync (GLsync);
+}
+#endif
+
+// how long a full ring may block on the oldest readback before it is dropped
+#define CAPTURE_TIMEOUT_NS 1000000000ull
+
+FrameCapture::FrameCapture()
+{
+    for (int i = 0; i < CAPTURE_RING_SIZE; i++) {
+        m_slots[i].pbo = 0;
+        m_slots[i].fence = 0;
+    }
+    m_oldest = m_pending = 0;
+    m_width = m_height = m_frames = 0;
+    m_encoder = NULL;
+}
+
+FrameCapture::~FrameCapture()
+{
+    stop();
+}
+
+bool FrameCapture::start(const QString &path, int width, int height, int fps)
+{
+    stop();
+
+    m_encoder = new FrameEncoder();
+    if (!m_encoder->open(path, width, height, fps)) {
+        delete m_encoder;
+        m_encoder = NULL;
+        return false;
+    }
+
+    m_width = width;
+    m_height = height;
+    m_frames = 0;
+    m_oldest = m_pending = 0;
+
+    GLuint pbos[CAPTURE_RING_SIZE];
+    glGenBuffers(CAPTURE_RING_SIZE, pbos);
+    for (int i = 0; i < CAPTURE_RING_SIZE; i++) {
+        m_slots[i].pbo = pbos[i];
+        m_slots[i].fence = 0;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbos[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, width * height * 4, 0, GL_STREAM_READ);
+        GLResources::add(GLResources::Buffer, pbos[i], width * height * 4, "capture readback");
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    if (!GLResources::checkError("allocating the capture buffers")) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+void FrameCapture::stop()
+{
+    if (!m_encoder) return;
+
+    // drain whatever is still in flight so the file ends on the last frame
+    while (m_pending > 0) retireOldest(true);
+
+    for (int i = 0; i < CAPTURE_RING_SIZE; i++) {
+        GLResources::remove(GLResources::Buffer, m_slots[i].pbo);
+        glDeleteBuffers(1, &m_slots[i].pbo);
+        m_slots[i].pbo = 0;
+    }
+
+    m_encoder->finish();
+    if (m_encoder->droppedFrames() > 0)
+        std::cout << "warning: " << m_encoder->droppedFrames() << " captured frames could not be written" << std::endl;
+    delete m_encoder;
+    m_encoder = NULL;
+}
+
+void FrameCapture::capture()
+{
+    if (!m_encoder) return;
+
+    // the ring is full: the oldest readback has to be collected before its
+    // buffer can be reused. With a deep enough ring it finished long ago.
+    if (m_pending == CAPTURE_RING_SIZE) retireOldest(true);
+
+    Slot &slot = m_slots[(m_oldest + m_pending) % CAPTURE_RING_SIZE];
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+    glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    m_pending++;
+
+    // hand over every older readback the GPU is already done with
+    while (m_pending > 1 && retireOldest(false));
+}
+
+bool FrameCapture::retireOldest(bool wait)
+{
+    Slot &slot = m_slots[m_oldest];
+
+    GLenum status = glClientWaitSync(slot.fence,
+                                     wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0,
+                                     wait ? CAPTURE_TIMEOUT_NS : 0);
+    if (status == GL_TIMEOUT_EXPIRED && !wait) return false;
+
+    bool ready = (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED);
+    if (ready) {
+        int size = m_width * m_height * 4;
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo);
+        const char *data = (const char *)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+        if (data) {
+            m_encoder->push(QByteArray(data, size));
+            m_frames++;
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    } else {
+        std::cout << "warning: Dropped a captured frame that never completed" << std::endl;
+    }
+
+    glDeleteSync(slot.fence);
+    slot.fence = 0;
+    m_oldest = (m_oldest + 1) % CAPTURE_RING_SIZE;
+    m_pending--;
+    return true;
+}
@@ -0,0 +1,46 @@
+#ifndef FRAMECAPTURE_H
+#define FRAMECAPTURE_H
+
+#include <qgl.h>
+#include <QString>
+
+// Number of pixel buffer objects in flight. A frame is handed to the encoder
+// up to CAPTURE_RING_SIZE - 1 frames after its readback was issued.
+#define CAPTURE_RING_SIZE 4
+
+class FrameEncoder;
+
+// Reads back the current read framebuffer into a ring of PBOs, each guarded
+// by a fence, so glReadPixels never waits for the frame it was issued in.
+// All methods must be called with the capturing GL context current.
+class FrameCapture
+{
+public:
+    FrameCapture();
+    ~FrameCapture();
+
+    bool start(const QString &path, int width, int height, int fps);
+    void stop();
+    void capture();
+
+    inline bool isActive() const { return m_encoder != NULL; }
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+    inline int frameCount() const { return m_frames; }
+
+private:
+    struct Slot
+    {
+        GLuint pbo;
+        GLsync fence;
+    };
+
+    bool retireOldest(bool wait);
+
+    Slot m_slots[CAPTURE_RING_SIZE];
+    int m_oldest, m_pending;
+    int m_width, m_height, m_frames;
+    FrameEncoder *m_encoder;
+};
+
+#endif // FRAMECAPTURE_H
@@ -0,0 +1,135 @@
+#include "frameencoder.h"
+#include <iostream>
+#include <string.h>
+
+FrameEncoder::FrameEncoder(QObject *parent) : QThread(parent)
+{
+    m_format = Raw;
+    m_width = m_height = 0;
+    m_fps = 60;
+    m_dropped = 0;
+    m_finished = false;
+}
+
+FrameEncoder::~FrameEncoder()
+{
+    finish();
+}
+
+FrameEncoder::Format FrameEncoder::formatForPath(const QString &path)
+{
+    return path.endsWith(".y4m", Qt::CaseInsensitive) ? Y4M : Raw;
+}
+
+bool FrameEncoder::open(const QString &path, int width, int height, int fps)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cout << "error: Cannot open capture file " << qPrintable(path) << std::endl;
+        return false;
+    }
+
+    m_format = formatForPath(path);
+    m_width = width;
+    m_height = height;
+    m_fps = fps;
+    m_dropped = 0;
+    m_finished = false;
+
+    if (m_format == Y4M) {
+        QByteArray header = QString("YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C444\n")
+                .arg(width).arg(height).arg(fps).toLatin1();
+        m_file.write(header);
+    }
+
+    start();
+    return true;
+}
+
+void FrameEncoder::push(const QByteArray &rgba)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_finished) return;
+
+    // apply back pressure instead of growing without bound; the capture side
+    // only calls this after a readback has completed, so the GPU keeps going
+    while (m_queue.size() >= ENCODER_QUEUE_SIZE) m_notfull.wait(&m_mutex);
+    m_queue.enqueue(rgba);
+    m_notempty.wakeOne();
+}
+
+void FrameEncoder::finish()
+{
+    if (!isRunning()) return;
+
+    m_mutex.lock();
+    m_finished = true;
+    m_notempty.wakeOne();
+    m_mutex.unlock();
+
+    wait();
+    m_file.close();
+}
+
+void FrameEncoder::run()
+{
+    for (;;) {
+        m_mutex.lock();
+        while (m_queue.isEmpty() && !m_finished) m_notempty.wait(&m_mutex);
+        if (m_queue.isEmpty()) {
+            m_mutex.unlock();
+            break;
+        }
+        QByteArray frame = m_queue.dequeue();
+        m_notfull.wakeOne();
+        m_mutex.unlock();
+
+        write(frame);
+    }
+}
+
+void FrameEncoder::write(const QByteArray &rgba)
+{
+    int pixels = m_width * m_height;
+    if (rgba.size() < pixels * 4) {
+        m_dropped++;
+        return;
+    }
+
+    const unsigned char *src = (const unsigned char *)rgba.constData();
+
+    if (m_format == Raw) {
+        // top-down rgb24, e.g. ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH
+        m_out.resize(pixels * 3);
+        unsigned char *dst = (unsigned char *)m_out.data();
+        for (int y = m_height - 1; y >= 0; y--) {
+            const unsigned char *row = src + y * m_width * 4;
+            for (int x = 0; x < m_width; x++) {
+                *dst++ = row[0];
+                *dst++ = row[1];
+                *dst++ = row[2];
+                row += 4;
+            }
+        }
+    } else {
+        // planar 4:4:4 BT.601 studio range
+        m_out.resize(pixels * 3 + 6);
+        unsigned char *dst = (unsigned char *)m_out.data();
+        memcpy(dst, "FRAME\n", 6);
+        unsigned char *Y = dst + 6;
+        unsigned char *U = Y + pixels;
+        unsigned char *V = U + pixels;
+        for (int y = m_height - 1; y >= 0; y--) {
+            const unsigned char *row = src + y * m_width * 4;
+            for (int x = 0; x < m_width; x++) {
+                int r = row[0], g = row[1], b = row[2];
+                *Y++ = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+                *U++ = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+                *V++ = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+                row += 4;
+            }
+        }
+    }
+
+    if (m_file.write(m_out) != m_out.size()) m_dropped++;
+}
@@ -0,0 +1,50 @@
+#ifndef FRAMEENCODER_H
+#define FRAMEENCODER_H
+
+#include <QThread>
+#include <QFile>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+
+// Number of frames that may wait for the encoder thread before push() blocks
+#define ENCODER_QUEUE_SIZE 8
+
+// Writes captured frames to disk on its own thread. Frames are handed over
+// exactly as glReadPixels produced them (bottom-up RGBA rows) and written
+// either as raw top-down rgb24 or as a 4:4:4 YUV4MPEG2 stream.
+class FrameEncoder : public QThread
+{
+public:
+    enum Format { Raw, Y4M };
+
+    FrameEncoder(QObject *parent = 0);
+    ~FrameEncoder();
+
+    bool open(const QString &path, int width, int height, int fps);
+    void push(const QByteArray &rgba);
+    void finish();
+
+    inline int droppedFrames() const { return m_dropped; }
+
+    static Format formatForPath(const QString &path);
+
+protected:
+    void run();
+
+private:
+    void write(const QByteArray &rgba);
+
+    QFile m_file;
+    Format m_format;
+    int m_width, m_height, m_fps, m_dropped;
+    bool m_finished;
+
+    QQueue<QByteArray> m_queue;
+    QMutex m_mutex;
+    QWaitCondition m_notempty, m_notfull;
+    QByteArray m_out; // conversion scratch space, only touched by run()
+};
+
+#endif // FRAMEENCODER_H
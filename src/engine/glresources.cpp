@@ -0,0 +1,144 @@
+#include "glresources.h"
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <iostream>
+
+struct Record
+{
+    qint64 bytes;
+    QByteArray label;
+};
+
+static QMutex s_mutex;
+static QHash<quint64, Record> s_records;
+static int s_count[GLResources::Categories + 1];
+static qint64 s_bytes[GLResources::Categories + 1];
+static qint64 s_peak[GLResources::Categories + 1];
+
+static inline quint64 key(GLResources::Category category, GLuint id)
+{
+    return ((quint64)category << 32) | id;
+}
+
+// adds delta to a category and to the total in the last slot
+static void account(GLResources::Category category, int count, qint64 delta)
+{
+    int index[2] = { category, GLResources::Categories };
+    for (int i = 0; i < 2; i++) {
+        s_count[index[i]] += count;
+        s_bytes[index[i]] += delta;
+        if (s_bytes[index[i]] > s_peak[index[i]]) s_peak[index[i]] = s_bytes[index[i]];
+    }
+}
+
+void GLResources::add(Category category, GLuint id, qint64 bytes, const char *label)
+{
+    QMutexLocker lock(&s_mutex);
+    quint64 k = key(category, id);
+    if (s_records.contains(k)) {
+        std::cout << "error: GL " << name(category) << " " << id << " (" << label
+                  << ") recorded twice, previously as " << s_records[k].label.constData() << std::endl;
+        account(category, -1, -s_records[k].bytes);
+    }
+    Record r;
+    r.bytes = bytes;
+    r.label = label;
+    s_records.insert(k, r);
+    account(category, 1, bytes);
+}
+
+void GLResources::resize(Category category, GLuint id, qint64 bytes)
+{
+    QMutexLocker lock(&s_mutex);
+    QHash<quint64, Record>::iterator r = s_records.find(key(category, id));
+    if (r == s_records.end()) {
+        std::cout << "error: Resizing unknown GL " << name(category) << " " << id << std::endl;
+        return;
+    }
+    account(category, 0, bytes - r->bytes);
+    r->bytes = bytes;
+}
+
+void GLResources::remove(Category category, GLuint id)
+{
+    if (!id) return;
+    QMutexLocker lock(&s_mutex);
+    QHash<quint64, Record>::iterator r = s_records.find(key(category, id));
+    if (r == s_records.end()) {
+        std::cout << "error: Deleting unknown GL " << name(category) << " " << id << std::endl;
+        return;
+    }
+    account(category, -1, -r->bytes);
+    s_records.erase(r);
+}
+
+int GLResources::count(Category category)
+{
+    QMutexLocker lock(&s_mutex);
+    return s_count[category];
+}
+
+qint64 GLResources::bytes(Category category)
+{
+    QMutexLocker lock(&s_mutex);
+    return s_bytes[category];
+}
+
+qint64 GLResources::peakBytes(Category category)
+{
+    QMutexLocker lock(&s_mutex);
+    return s_peak[category];
+}
+
+QJsonObject GLResources::report()
+{
+    QMutexLocker lock(&s_mutex);
+    QJsonObject report;
+    for (int i = 0; i <= Categories; i++) {
+        QJsonObject c;
+        c.insert("objects", s_count[i]);
+        c.insert("bytes", (double)s_bytes[i]);
+        c.insert("peak_bytes", (double)s_peak[i]);
+        report.insert(i == Categories ? "total" : name((Category)i), c);
+    }
+    return report;
+}
+
+int GLResources::reportLeaks()
+{
+    QMutexLocker lock(&s_mutex);
+    for (QHash<quint64, Record>::const_iterator r = s_records.constBegin(); r != s_records.constEnd(); ++r) {
+        std::cout << "error: Leaked GL " << name((Category)(r.key() >> 32)) << " " << (GLuint)r.key()
+                  << " (" << r->label.constData() << ", " << r->bytes << " bytes)" << std::endl;
+    }
+    return s_records.size();
+}
+
+bool GLResources::checkError(const char *what)
+{
+    bool ok = true;
+    for (GLenum e = glGetError(); e != GL_NO_ERROR; e = glGetError()) {
+        std::cout << "error: GL error 0x" << std::hex << e << std::dec << " while " << what << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+qint64 GLResources::textureBytes(int width, int height, int bytes_per_texel, bool mipmaps)
+{
+    qint64 bytes = (qint64)width * height * bytes_per_texel;
+    while (mipmaps && (width > 1 || height > 1)) {
+        width = qMax(width / 2, 1);
+        height = qMax(height / 2, 1);
+        bytes += (qint64)width * height * bytes_per_texel;
+    }
+    return bytes;
+}
+
+const char *GLResources::name(Category category)
+{
+    static const char *names[Categories] = { "buffer", "texture", "framebuffer", "renderbuffer", "program", "query" };
+    return names[category];
+}
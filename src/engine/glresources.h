@@ -0,0 +1,48 @@
+#ifndef GLRESOURCES_H
+#define GLRESOURCES_H
+
+#include <qgl.h>
+#include <QJsonObject>
+
+// Book-keeping of every GL object the application creates, for sizing
+// deployments and finding leaks. Each glGen* site records its objects with
+// the bytes they hold and removes them again right before deleting them:
+//
+//     glGenBuffers(1, &vbo);
+//     glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+//     GLResources::add(GLResources::Buffer, vbo, size, "mesh");
+//     ...
+//     GLResources::remove(GLResources::Buffer, vbo);
+//     glDeleteBuffers(1, &vbo);
+//
+// Sizes are what was requested from GL; drivers add padding and their own
+// overhead on top. All functions may be called from any thread.
+class GLResources
+{
+public:
+    enum Category { Buffer, Texture, Framebuffer, Renderbuffer, Program, Query, Categories };
+
+    static void add(Category category, GLuint id, qint64 bytes, const char *label);
+    static void resize(Category category, GLuint id, qint64 bytes);
+    static void remove(Category category, GLuint id);
+
+    static int count(Category category);
+    static qint64 bytes(Category category);
+    static qint64 peakBytes(Category category);
+
+    // current and peak bytes and object counts per category and in total
+    static QJsonObject report();
+    // prints every object that is still recorded, returns their number
+    static int reportLeaks();
+
+    // drains glGetError(), printing every error as having happened while
+    // doing what. Returns false if there was one.
+    static bool checkError(const char *what);
+
+    // bytes of a width x height texture, with its full mipmap chain if set
+    static qint64 textureBytes(int width, int height, int bytes_per_texel, bool mipmaps);
+
+    static const char *name(Category category);
+};
+
+#endif // GLRESOURCES_H
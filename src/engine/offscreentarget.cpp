@@ -0,0 +1,71 @@
+#include "offscreentarget.h"
+#include "glresources.h"
+#include <iostream>
+
+#ifndef __APPLE__
+extern "C"
+{
+    void glBindFramebuffer(GLenum, GLuint);
+    void glGenFramebuffers(GLsizei, GLuint *);
+    void glDeleteFramebuffers(GLsizei, const GLuint *);
+    void glFramebufferRenderbuffer(GLenum, GLenum, GLenum, GLuint);
+    GLenum glCheckFramebufferStatus(GLenum);
+    void glBindRenderbuffer(GLenum, GLuint);
+    void glGenRenderbuffers(GLsizei, GLuint *);
+    void glDeleteRenderbuffers(GLsizei, const GLuint *);
+    void glRenderbufferStorage(GLenum, GLenum, GLsizei, GLsizei);
+}
+#endif
+
+OffscreenTarget::OffscreenTarget(int width, int height, const char *label)
+{
+    m_width = width;
+    m_height = height;
+    glGenFramebuffers(1, &m_fbo);
+    glGenRenderbuffers(2, m_rb);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_rb[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, m_rb[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    GLResources::add(GLResources::Framebuffer, m_fbo, 0, label);
+    GLResources::add(GLResources::Renderbuffer, m_rb[0], (qint64)width * height * 4, label);
+    GLResources::add(GLResources::Renderbuffer, m_rb[1], (qint64)width * height * 4, label);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_rb[0]);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_rb[1]);
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    m_valid = GLResources::checkError("creating an offscreen framebuffer");
+    if (m_valid && status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "error: Offscreen framebuffer (" << label << ") incomplete, status 0x"
+                  << std::hex << status << std::dec << std::endl;
+        m_valid = false;
+    }
+}
+
+OffscreenTarget::~OffscreenTarget()
+{
+    GLResources::remove(GLResources::Framebuffer, m_fbo);
+    glDeleteFramebuffers(1, &m_fbo);
+    GLResources::remove(GLResources::Renderbuffer, m_rb[0]);
+    GLResources::remove(GLResources::Renderbuffer, m_rb[1]);
+    glDeleteRenderbuffers(2, m_rb);
+}
+
+void OffscreenTarget::bind()
+{
+    glBindFramebuffer(GL_FRAMEBUFFER, m_fbo);
+}
+
+QImage OffscreenTarget::read()
+{
+    QImage image(m_width, m_height, QImage::Format_RGB888);
+    // QImage lines are 4-byte aligned like GL's default packing
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    bind();
+    glReadPixels(0, 0, m_width, m_height, GL_RGB, GL_UNSIGNED_BYTE, image.bits());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return image.mirrored();
+}
@@ -0,0 +1,30 @@
+#ifndef OFFSCREENTARGET_H
+#define OFFSCREENTARGET_H
+
+#include <qgl.h>
+#include <QImage>
+
+// Color and depth framebuffer to render into without a window, created in
+// the current context. The label names its objects in GLResources.
+class OffscreenTarget
+{
+public:
+    OffscreenTarget(int width, int height, const char *label);
+    ~OffscreenTarget();
+
+    // false if it could not be created; the error has been printed
+    inline bool isValid() const { return m_valid; }
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+
+    void bind();
+    // the whole target as RGB, top row first; binds the default framebuffer
+    QImage read();
+
+private:
+    int m_width, m_height;
+    GLuint m_fbo, m_rb[2];
+    bool m_valid;
+};
+
+#endif // OFFSCREENTARGET_H
@@ -0,0 +1,202 @@
+#include "shadercache.h"
+#include "glresources.h"
+#include <QFile>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QFileSystemWatcher>
+#include <iostream>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef __APPLE__
+extern "C"
+{
+    void glGetProgramiv (GLuint, GLenum, GLint *);
+    void glProgramParameteri (GLuint, GLenum, GLint);
+    void glGetProgramBinary (GLuint, GLsizei, GLsizei *, GLenum *, GLvoid *);
+    void glProgramBinary (GLuint, GLenum, const GLvoid *, GLsizei);
+}
+#endif
+
+// program binaries need GL 4.1 or ARB_get_program_binary; asking for them
+// otherwise would leave GL_INVALID_ENUM for the caller's next error check
+static bool hasProgramBinaries()
+{
+    const char *version = (const char *)glGetString(GL_VERSION);
+    const char *extensions = (const char *)glGetString(GL_EXTENSIONS);
+    int major = 0, minor = 0;
+    if (version) sscanf(version, "%d.%d", &major, &minor);
+    return major > 4 || (major == 4 && minor >= 1)
+        || (extensions && strstr(extensions, "GL_ARB_get_program_binary"));
+}
+
+ShaderCache::ShaderCache(const QString &source_dir, QObject *parent) : QObject(parent)
+{
+    m_source_dir = source_dir;
+    m_reload = false;
+    m_watcher = NULL;
+
+    // caching also needs at least one supported binary format
+    m_has_binaries = hasProgramBinaries();
+    GLint formats = 0;
+    if (m_has_binaries) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    m_binaries = formats > 0 && source_dir.isEmpty();
+
+    if (m_binaries) {
+        m_cache_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/shaders";
+        if (!QDir().mkpath(m_cache_dir)) m_binaries = false;
+    }
+
+    if (!source_dir.isEmpty()) {
+        m_watcher = new QFileSystemWatcher(this);
+        connect(m_watcher, SIGNAL(fileChanged(QString)), this, SLOT(sourceChanged(QString)));
+    }
+}
+
+ShaderCache::~ShaderCache()
+{
+}
+
+QByteArray ShaderCache::source(const QString &name)
+{
+    QString path = m_source_dir.isEmpty() ? ":/shaders/" + name
+                                          : QDir(m_source_dir).filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        std::cout << "error: Cannot read shader " << qPrintable(path) << std::endl;
+        return QByteArray();
+    }
+    if (m_watcher && !m_watcher->files().contains(path)) m_watcher->addPath(path);
+    return file.readAll();
+}
+
+QGLShaderProgram *ShaderCache::program(const QString &vertex, const QString &fragment,
+                                       const QByteArray &defines)
+{
+    QByteArray vsrc, fsrc;
+    if (!vertex.isEmpty()) {
+        vsrc = source(vertex);
+        if (vsrc.isEmpty()) return NULL;
+        if (!defines.isEmpty()) vsrc.prepend(defines + "\n");
+    }
+    fsrc = source(fragment);
+    if (fsrc.isEmpty()) return NULL;
+    if (!defines.isEmpty()) fsrc.prepend(defines + "\n");
+
+    QString path;
+    if (m_binaries) {
+        path = binaryPath(vsrc, fsrc);
+        QGLShaderProgram *prog = loadBinary(path);
+        if (prog) {
+            track(prog, fragment);
+            return prog;
+        }
+    }
+
+    QGLShaderProgram *prog = new QGLShaderProgram();
+    bool ok = true;
+    if (!vsrc.isEmpty()) ok = prog->addShaderFromSourceCode(QGLShader::Vertex, vsrc);
+    ok = ok && prog->addShaderFromSourceCode(QGLShader::Fragment, fsrc);
+    if (ok && m_binaries)
+        glProgramParameteri(prog->programId(), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    if (!ok || !prog->link()) {
+        std::cout << "error: Cannot build " << qPrintable(vertex) << " " << qPrintable(fragment)
+                  << ":" << std::endl << qPrintable(prog->log()) << std::endl;
+        delete prog;
+        return NULL;
+    }
+
+    if (m_binaries) saveBinary(path, prog->programId());
+    track(prog, fragment);
+    return prog;
+}
+
+void ShaderCache::track(QGLShaderProgram *prog, const QString &name)
+{
+    // the binary size is the closest thing to the program's footprint GL
+    // reports, 0 where there are no program binaries
+    GLint length = 0;
+    if (m_has_binaries) glGetProgramiv(prog->programId(), GL_PROGRAM_BINARY_LENGTH, &length);
+    GLResources::add(GLResources::Program, prog->programId(), length, qPrintable(name));
+}
+
+void ShaderCache::destroy(QGLShaderProgram *prog)
+{
+    if (!prog) return;
+    GLResources::remove(GLResources::Program, prog->programId());
+    delete prog;
+}
+
+QString ShaderCache::binaryPath(const QByteArray &vertex, const QByteArray &fragment) const
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(vertex);
+    hash.addData("\0", 1);
+    hash.addData(fragment);
+    hash.addData("\0", 1);
+    hash.addData((const char *)glGetString(GL_VENDOR));
+    hash.addData((const char *)glGetString(GL_RENDERER));
+    hash.addData((const char *)glGetString(GL_VERSION));
+    return m_cache_dir + "/" + hash.result().toHex() + ".bin";
+}
+
+QGLShaderProgram *ShaderCache::loadBinary(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return NULL;
+    QByteArray data = file.readAll();
+    if (data.size() <= (int)sizeof(GLenum)) return NULL;
+
+    GLenum format;
+    memcpy(&format, data.constData(), sizeof(format));
+
+    // QGLShaderProgram::link() accepts a program that was populated with a
+    // binary and has no shaders attached
+    QGLShaderProgram *prog = new QGLShaderProgram();
+    glProgramBinary(prog->programId(), format, data.constData() + sizeof(format),
+                    data.size() - sizeof(format));
+    while (glGetError() != GL_NO_ERROR);
+    if (!prog->link()) {
+        // rejected by this driver after all, it gets rebuilt and replaced
+        delete prog;
+        return NULL;
+    }
+    return prog;
+}
+
+void ShaderCache::saveBinary(const QString &path, GLuint program)
+{
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    GLenum format = 0;
+    QByteArray data(sizeof(format) + length, 0);
+    glGetProgramBinary(program, length, &length, &format, data.data() + sizeof(format));
+    if (glGetError() != GL_NO_ERROR) return;
+    memcpy(data.data(), &format, sizeof(format));
+    data.resize(sizeof(format) + length);
+
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(data);
+        file.commit();
+    }
+}
+
+bool ShaderCache::reloadPending()
+{
+    bool reload = m_reload;
+    m_reload = false;
+    return reload;
+}
+
+void ShaderCache::sourceChanged(const QString &path)
+{
+    // editors that save by renaming drop the file from the watch list
+    if (!m_watcher->files().contains(path) && QFileInfo(path).exists()) m_watcher->addPath(path);
+    m_reload = true;
+}
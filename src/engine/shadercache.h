@@ -0,0 +1,53 @@
+#ifndef SHADERCACHE_H
+#define SHADERCACHE_H
+
+#include <qgl.h>
+#include <QGLShaderProgram>
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+
+class QFileSystemWatcher;
+
+// Builds shader programs from the files in shaders/ and keeps their linked
+// binaries on disk (glGetProgramBinary), keyed on a hash of the sources,
+// the driver and the GL version, so later launches skip compiling.
+//
+// By default the sources are the copies embedded from shaders.qrc. When a
+// source directory is set they are read from there instead, the binary cache
+// is bypassed and the files are watched so the caller can rebuild its
+// programs when reloadPending() turns true.
+class ShaderCache : public QObject
+{
+Q_OBJECT
+public:
+    ShaderCache(const QString &source_dir = QString(), QObject *parent = 0);
+    ~ShaderCache();
+
+    // vertex may be empty for fragment-only programs. defines is prepended to
+    // both stages, for specialized variants of the same sources. Returns NULL
+    // and prints the log if the program does not build.
+    QGLShaderProgram *program(const QString &vertex, const QString &fragment,
+                              const QByteArray &defines = QByteArray());
+
+    bool reloadPending();
+
+    // deletes a program returned by program(), NULL is ignored
+    static void destroy(QGLShaderProgram *prog);
+
+private slots:
+    void sourceChanged(const QString &path);
+
+private:
+    QByteArray source(const QString &name);
+    QString binaryPath(const QByteArray &vertex, const QByteArray &fragment) const;
+    QGLShaderProgram *loadBinary(const QString &path);
+    void saveBinary(const QString &path, GLuint program);
+    void track(QGLShaderProgram *prog, const QString &name);
+
+    QString m_source_dir, m_cache_dir;
+    bool m_has_binaries, m_binaries, m_reload;
+    QFileSystemWatcher *m_watcher;
+};
+
+#endif // SHADERCACHE_H
@@ -1,14 +1,12 @@
 #include "waterengine.h"
+#include "waterresources.h"
+#include "glresources.h"
 #include <iostream>
 
 #ifndef __APPLE__
 extern "C"
 {
     void glBindBuffer (GLenum, GLuint);
-    void glDeleteBuffers (GLsizei, const GLuint *);
-    void glGenBuffers (GLsizei, GLuint *);
-    GLboolean glIsBuffer (GLuint);
-    void glBufferData (GLenum, GLsizeiptr, const GLvoid *, GLenum);
     void glBindFramebuffer(GLenum, GLuint);
     void glFramebufferTexture2D(GLenum, GLenum, GLenum, GLuint, GLint);
     GLenum glCheckFramebufferStatus(GLenum);
@@ -17,34 +15,10 @@ extern "C"
 }
 #endif
 
-#define DIM 300
-#define UNIT 1.f
-#define TEXSIZE 256 
 #define GW GEOMETRIC_WAVES
 #define NMW NORMALMAP_WAVES
 
-WaterEngine::Wave::Wave() {}
-WaterEngine::Wave::Wave(const WaveParameters &p)
-{
-    float wl = p.wavelength;
-    wl = frand() * (2.f * wl - 0.7f * wl) + 0.7f * wl;
-
-    static float angle = frandf() * M_PI_4;// - M_PI_2;
-    float c = cos(angle);
-    float s = sin(angle);
-    Vector2 dir(c * p.wave_dir.x,
-                s * p.wave_dir.y);
-    dir = Vector2::fromAngle(frandf() * M_PI_4); 
-    float st = p.steepness;
-
-    params.wavelength = wl;
-    params.steepness = st;
-    params.speed = sqrt(9.81f * 2.f*M_PI/wl)*wl*p.speed; 
-    params.kAmpOverLen = p.kAmpOverLen;
-    params.wave_dir = Vector2::randomDirection();//dir.unit();
-}
-
-WaterEngine::WaterEngine()
+WaterEngine::WaterEngine(const QString &shader_dir, const GridSettings &grid, WaterEngine *share)
 {
     glClearColor(0.59f, 0.78f, 0.93f, 1.f);
 
@@ -65,283 +39,157 @@ WaterEngine::WaterEngine()
     // enable back face culling
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_CULL_FACE);
-    
-    // seed random
-    srand(time(0));
-
-    // initialize parameters
-    m_params.wavelength = 10.f;
-    m_params.steepness = 0.8f;
-    m_params.kAmpOverLen = 0.02f;
-    m_params.speed = 0.15f;
-    m_params.wave_dir = Vector2(1.f, 0.8f).unit();
-
-    // initialize waves
-    initializeWaves();
-
-    // build vbo with base mesh
-    unsigned int size = (DIM)*(DIM)*4;
-    Vector3 *vertices = new Vector3[size];
-    Vector3 *v = &vertices[0];
-    float x, z;
-    z = -DIM/2.f;
-    for (int i = 0; i < DIM/UNIT; i++) {
-        x = -DIM/2.f;
-        for (int j = 0; j < DIM/UNIT; j++) {
-            v->x = x;
-            v->y = 0.f;
-            v->z = z;
-            v++;
-            v->x = x;
-            v->y = 0.f;
-            v->z = z + UNIT;
-            v++;
-            v->x = x + UNIT;
-            v->y = 0.f;
-            v->z = z + UNIT;
-            v++;
-            v->x = x + UNIT;
-            v->y = 0.f;
-            v->z = z;
-            v++;
-            x += UNIT;
-        }
-        z += UNIT;
-    }
 
-    glGenBuffers(1, &m_vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glBufferData(GL_ARRAY_BUFFER, size * sizeof(Vector3), (GLvoid *)vertices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    m_count = size;
-    delete[] vertices;
-
-    // setup the framebuffer for normal map generation
     glEnable(GL_TEXTURE_2D);
-    glGenTextures(1, &m_normalmap);
-    glBindTexture(GL_TEXTURE_2D, m_normalmap);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, TEXSIZE, TEXSIZE, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
-    glBindTexture(GL_TEXTURE_2D, 0);
 
+    // mesh, normal map texture, programs and waves
+    m_shared = share ? share->m_shared : new WaterResources(shader_dir, grid);
+    m_shared->ref();
+    m_valid = true;
+
+    // setup the framebuffer for normal map generation, framebuffers are
+    // per context
     glGenFramebuffers(1, &m_nmfbo);
     glBindFramebuffer(GL_FRAMEBUFFER, m_nmfbo);
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_normalmap, 0);
-    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
-        std::cout << "error: Problem creating framebuffer" << std::endl;
-        exit(0); 
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_shared->normalMap(), 0);
+    GLResources::add(GLResources::Framebuffer, m_nmfbo, 0, "normal map");
+    GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+    if (status != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "error: Normal map framebuffer incomplete, status 0x" << std::hex << status << std::dec << std::endl;
+        m_valid = false;
     }
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    // shader program that generates the normal map
-    m_nmprog = new QGLShaderProgram();
-    m_nmprog->addShaderFromSourceCode(QGLShader::Fragment,
-            "uniform float time;"
-            "uniform float waves[300];"
-            
-            "void calc_normal(in vec2 uv, out vec3 N)"
-            "{"
-            "   float PI = 3.14159265358979323846264;"
-            "   N = vec3(0.0, 0.0, 1.0);"
-            "   for (int i = 0; i < 300; i += 6) {"
-            "       float A = waves[i] * waves[i+3];"         // Amplitude
-            "       float omega = 2.0 * PI / waves[i];"       // Frequency
-            "       float phi = waves[i+2] * omega;"          // Phase
-            "       float k = waves[i+1];"
-            "       float term = omega * dot(vec2(waves[i+4], waves[i+5]), uv) + phi * time;"
-            "       float C = cos(term);"
-            "       float S = sin(term);"
-            "       float val = pow(0.5 * (S + 1.0), k - 1.0) * C;"
-            "       val = omega * A * k * val;"
-            "       N += vec3(waves[i+4] * val,"
-            "                 waves[i+5] * val,"
-            "                 0.0);"
-            "   }"
-            "   N = normalize(N);" 
-            "}"
-
-            "void main(void)"
-            "{"
-            "   vec3 N;"
-            "   calc_normal(gl_FragCoord.st/128.0, N);"
-            "   N = (N * 0.5) + 0.5;"
-            "   gl_FragColor = vec4(N.xyz, 1.0);"
-            "}");
-
-    m_nmprog->link();
-
-    // shader program that produces the final render
-    m_waveprog = new QGLShaderProgram();
-    m_waveprog->addShaderFromSourceCode(QGLShader::Vertex,
-
-            "void wave_function(in float waves[24], in float time, in vec3 pos,"
-            "                   out vec3 P, out vec3 N, out vec3 B, out vec3 T)"
-            "{"
-            "   float PI = 3.14159265358979323846264;"
-            "   P = pos;"
-            "   for (int i = 0; i < 24; i += 6) {"
-            "       float A = waves[i] * waves[i+3];"         // Amplitude
-            "       float omega = 2.0 * PI / waves[i];"       // Frequency
-            "       float phi = waves[i+2] * omega;"          // Phase
-            "       float Qi = waves[i+1]/(omega * A * 4.0);" // Steepness
-
-            "       float term = omega * dot(vec2(waves[i+4], waves[i+5]), vec2(pos.x, pos.z)) + phi * time;"
-            "       float C = cos(term);"
-            "       float S = sin(term);"
-            "       P += vec3(Qi * A * waves[i+4] * C,"
-            "                 A * S,"
-            "                 Qi * A * waves[i+5] * C);"
-            "   }"
-            "   B = vec3(0.0);"
-            "   T = vec3(0.0);"
-            "   N = vec3(0.0);"
-            "   for (int i = 0; i < 24; i += 6) {"
-            "       float A = waves[i] * waves[i+3];"         // Amplitude
-            "       float omega = 2.0 * PI / waves[i];"       // Frequency
-            "       float phi = waves[i+2] * omega;"          // Phase
-            "       float Qi = waves[i+1]/(omega * A * 4.0);" // Steepness
-
-            "       float WA = omega * A;"
-            "       float term = omega * dot(vec2(waves[i+4], waves[i+5]), vec2(P.x, P.z)) + phi * time;"
-            "       float C = cos(term)/6.0;"
-            "       float S = sin(term);"
-            "       B += vec3 (Qi * waves[i+4]*waves[i+4] * WA * S,"
-            "                  Qi * waves[i+4] * waves[i+5] * WA * S,"
-            "                  waves[i+4] * WA * C);"
-
-            "       T += vec3 (Qi * waves[i+4] * waves[i+5] * WA * S,"
-            "                  Qi * waves[i+5] * waves[i+5] * WA * S,"
-            "                  waves[i+5] * WA * C);"
-
-            "       N += vec3 (waves[i+4] * WA * C,"
-            "                  waves[i+5] * WA * C,"
-            "                  Qi * WA * S);"
-            "   }"
-            "   B = normalize(vec3(1.0 - B.x, -B.y, B.z));"
-            "   T = normalize(vec3(-T.x, 1.0 - T.y, T.z));"
-            "   N = normalize(vec3(-N.x, -N.y, 1.0 - N.z));"
-            "}"
-            
-            "uniform float waves[24];"
-            "uniform float time;"
-            "uniform vec3 light;"
-
-            "varying vec2 texcoord;"
-            "varying vec3 lightv;"
-            "varying vec3 viewv;"
-            "void main(void)"
-            "{"
-            "   vec3 P, N, B, T;"
-            "   wave_function(waves, time, gl_Vertex.xyz, P, N, B, T);"
-            "   lightv = vec3(dot(light, B),"
-            "                 dot(light, T),"
-            "                 dot(light, N));"
-            "   lightv = normalize(lightv);"
-            "   vec3 pos = (gl_ModelViewMatrix * vec4(P.xyz, 1.0)).xyz;"
-            "   viewv = vec3(dot(pos, B),"
-            "                dot(pos, T),"
-            "                dot(pos, N));"
-            "   viewv = normalize(viewv);"
-            "   texcoord = vec2(P.x, P.z) * 0.5 + 0.5;"
-            "   gl_Position = gl_ProjectionMatrix * vec4(pos, 1.0);"
-            "}");
-
-    m_waveprog->addShaderFromSourceCode(QGLShader::Fragment,
-            "uniform sampler2D normalmap;"
-
-            "varying vec2 texcoord;"
-            "varying vec3 lightv;"
-            "varying vec3 viewv;"
-            "void main(void)"
-            "{"
-            "   vec3 N = texture2D(normalmap, texcoord*0.125).xyz * 2.0 - 1.0;"
-            "   N = normalize(N);"
-            "   vec3 specular = vec3(1.0) * pow(clamp(dot(reflect(normalize(lightv), N), viewv), 0.0, 1.0), 50.0);"
-            "   vec3 oceanblue = vec3(0.0, 0.0, 0.2);"
-            "   vec3 skyblue = vec3(0.39, 0.52, 0.93) * 0.9;"
-            "   const float R_0 = 0.4;"
-            "   float fresnel = R_0 + (1.0 - R_0) * pow((1.0 - dot(-normalize(viewv), N)), 5.0);"
-            "   fresnel = max(0.0, min(fresnel, 1.0));"
-            "   gl_FragColor = vec4(mix(oceanblue, skyblue, fresnel) + specular, 1.0);"
-            "}");
-    m_waveprog->link();
 }
 
 WaterEngine::~WaterEngine()
 {
-    glDeleteBuffers(1, &m_vbo);
+    GLResources::remove(GLResources::Framebuffer, m_nmfbo);
     glDeleteFramebuffers(1, &m_nmfbo);
-    glDeleteTextures(1, &m_normalmap);
-    delete m_waveprog;
-    delete m_nmprog;
+    if (m_shared->deref()) delete m_shared;
 }
 
-void WaterEngine::initializeWaves()
+const WaveParameters &WaterEngine::parameters() const
 {
-    // initialize geometric waves
-    for (int i = 0; i < GW; i++) {
-        m_geo_waves[i] = m_params;
-    }
+    return m_shared->waves().parameters();
+}
 
-    // initialize normal map waves
-    for (int i = 0; i < NMW; i++) {
-        float wl = m_nm_waves[i].params.wavelength = (frandf() * 0.5f + 0.3f);
-//#define SHITTY_TILE
-#ifdef SHITTY_TILE
-        // tile but shitty
-        m_nm_waves[i].params.wave_dir = (Vector2::randomDirection()*6.f).floor()/2.f * wl;
-#else   
-        // not shitty but not tiled
-        m_nm_waves[i].params.wave_dir = (Vector2::randomDirection());
-#endif
-        m_nm_waves[i].params.steepness = 5.f*(frandf() * 2.f + 1.f);
-        m_nm_waves[i].params.speed = 0.05f * sqrt(M_PI/wl);
-        m_nm_waves[i].params.kAmpOverLen = 0.03f;
+void WaterEngine::setParameters(const WaveParameters &params)
+{
+    m_shared->waves().setParameters(params);
+    m_shared->setNormalMapStale(true);
+}
+
+void WaterEngine::setBlendTime(float seconds)
+{
+    m_shared->waves().setBlendTime(seconds);
+}
+
+void WaterEngine::randomizeWaves()
+{
+    m_shared->waves().randomize();
+    m_shared->setNormalMapStale(true);
+}
+
+void WaterEngine::setWaveTime(float elapsed_time)
+{
+    m_shared->setTime(elapsed_time);
+}
+
+const GridSettings &WaterEngine::grid() const
+{
+    return m_shared->grid();
+}
+
+void WaterEngine::setGrid(const GridSettings &grid)
+{
+    m_shared->setGrid(grid);
+}
+
+bool WaterEngine::gridPending() const
+{
+    return m_shared->gridPending();
+}
+
+bool WaterEngine::isValid() const
+{
+    return m_valid && m_shared->isValid();
+}
+
+const float *WaterEngine::geometricWaves() const
+{
+    return (const float *)m_shared->waves().geometric();
+}
+
+void WaterEngine::renderNormalMap()
+{
+    QGLShaderProgram *nmprog = m_shared->normalMapProgram();
+    GLuint normalmap = m_shared->normalMap();
+
+    // set projection matrix to identity
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glMatrixMode(GL_MODELVIEW);
+   
+    // render the normal map, one pass per mipmap level, then return to the
+    // framebuffer the caller was drawing into
+    GLint target;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &target);
+    nmprog->bind();
+    nmprog->setUniformValueArray("waves", (const GLfloat *)m_shared->waves().normalMap(), NMW * sizeof(WaveRecord)/sizeof(float), 1);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, m_nmfbo);
+    // the texture spans two normal map units whatever its size
+    int texsize = m_shared->normalMapSize();
+    for (int level = 0; level < m_shared->normalMapLevels(); level++) {
+        int size = texsize >> level;
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, normalmap, level);
+        glViewport(0, 0, size, size);
+        nmprog->setUniformValue("texel", 2.f * (1 << level) / texsize);
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        glPushMatrix();
+        glLoadIdentity();
+        glBegin(GL_QUADS);
+        glColor3f(1.f, 0.f, 0.f); glVertex3f(-1.f, -1.f, -1.f);
+        glColor3f(1.f, 1.f, 0.f); glVertex3f( 1.f, -1.f, -1.f);
+        glColor3f(0.f, 1.f, 0.f); glVertex3f( 1.f,  1.f, -1.f);
+        glColor3f(0.f, 0.f, 1.f); glVertex3f(-1.f,  1.f, -1.f);
+        glEnd();
+        glPopMatrix();
     }
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    nmprog->release();
+
+    // other contexts only see the new contents after a flush here
+    glFlush();
+    m_shared->setNormalMapStale(false);
 }
 
 void WaterEngine::render(float elapsed_time)
 {
+    if (!isValid() || !m_shared->preparePrograms()) return;
+
+    // the first view to render a new time advances the shared waves
+    m_shared->update(elapsed_time);
+    m_shared->updateGrid();
+    const WaveSet &waves = m_shared->waves();
+    QGLShaderProgram *waveprog = m_shared->waveProgram();
+
     // store current viewport and projection matrix
     int vp[4];
     float proj[16];
     glGetIntegerv(GL_VIEWPORT, vp);
     glGetFloatv(GL_PROJECTION_MATRIX, proj);
 
-    // set projection matrix to identity, set viewport to
-    // normal map dimensions
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glMatrixMode(GL_MODELVIEW);
-    glViewport(0, 0, TEXSIZE, TEXSIZE);
-   
-    // render normal map
-    m_nmprog->bind();
-    m_nmprog->setUniformValue("time", elapsed_time);
-    m_nmprog->setUniformValueArray("waves", (const GLfloat *)m_nm_waves, NMW * sizeof(Wave)/sizeof(float), 1);
-
-    glBindFramebuffer(GL_FRAMEBUFFER, m_nmfbo);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glPushMatrix();
-    glLoadIdentity();
-    glBegin(GL_QUADS);
-    glColor3f(1.f, 0.f, 0.f); glVertex3f(-1.f, -1.f, -1.f);
-    glColor3f(1.f, 1.f, 0.f); glVertex3f( 1.f, -1.f, -1.f);
-    glColor3f(0.f, 1.f, 0.f); glVertex3f( 1.f,  1.f, -1.f);
-    glColor3f(0.f, 0.f, 1.f); glVertex3f(-1.f,  1.f, -1.f);
-    glEnd();
-    glPopMatrix();
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-    m_nmprog->release();
+    if (m_shared->normalMapStale()) {
+        renderNormalMap();
 
-    // restore viewport and projection
-    glViewport(vp[0], vp[1], vp[2], vp[3]);
-    glMatrixMode(GL_PROJECTION);
-    glMultMatrixf(proj);
-    glMatrixMode(GL_MODELVIEW);
+        // restore viewport and projection
+        glViewport(vp[0], vp[1], vp[2], vp[3]);
+        glMatrixMode(GL_PROJECTION);
+        glLoadMatrixf(proj);
+        glMatrixMode(GL_MODELVIEW);
+    }
 
     glPushMatrix();
 
@@ -349,24 +197,26 @@ void WaterEngine::render(float elapsed_time)
 
     /* render waves */
     glColor3f(1.f, 1.f, 1.f);
-    glBindTexture(GL_TEXTURE_2D, m_normalmap);
-    m_waveprog->bind();
-    m_waveprog->setUniformValue("time", elapsed_time);
-    m_waveprog->setUniformValueArray("waves", (const GLfloat *)m_geo_waves, GW * sizeof(Wave)/sizeof(float), 1);
-    m_waveprog->setUniformValue("light", 0.f, 100.f, 0.f);
-    m_waveprog->setUniformValue("normalmap", 0);
-
-    glBindBuffer(GL_ARRAY_BUFFER, m_vbo);
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glVertexPointer(3, GL_FLOAT, 0, 0);
-    glDrawArrays(GL_QUADS, 0, m_count);
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-    m_waveprog->release();
+    glBindTexture(GL_TEXTURE_2D, m_shared->normalMap());
+    waveprog->bind();
+    waveprog->setUniformValueArray("waves", (const GLfloat *)waves.geometric(), GW * sizeof(WaveRecord)/sizeof(float), 1);
+    waveprog->setUniformValue("light", 0.f, 100.f, 0.f);
+    // pixel size at unit depth, from the projection's cot(fovy/2)
+    waveprog->setUniformValue("footprint", 2.f / (proj[5] * vp[3]));
+    waveprog->setUniformValue("normalmap", 0);
+
+    // there is no mesh until the first one has been uploaded
+    if (m_shared->vbo()) {
+        glBindBuffer(GL_ARRAY_BUFFER, m_shared->vbo());
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, 0);
+        glDrawArrays(GL_QUADS, 0, m_shared->vertexCount());
+        glDisableClientState(GL_VERTEX_ARRAY);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    waveprog->release();
     glBindTexture(GL_TEXTURE_2D, 0);
 
     glPopMatrix();
 }
-
-
@@ -5,46 +5,51 @@
 #include <QGLShaderProgram>
 
 #include "vector.h"
+#include "waveset.h"
 
-#define GEOMETRIC_WAVES 4
-#define NORMALMAP_WAVES 50
-
-struct WaveParameters
-{
-    float wavelength;
-    float steepness;
-    float speed;
-    float kAmpOverLen;
-    Vector2 wave_dir; 
-};
+class WaterResources;
 
+// Renders the ocean into the current context. Engines of views whose
+// contexts share objects pass the first one as share and then use a single
+// set of WaterResources, so each further view only adds its own framebuffer
+// and the normal map is rendered once per frame for all of them.
 class WaterEngine
 {
 public:
-    WaterEngine();
+    WaterEngine(const QString &shader_dir = QString(), const GridSettings &grid = GridSettings(),
+                WaterEngine *share = NULL);
     ~WaterEngine();
 
-    inline const WaveParameters &parameters() const { return m_params; }
-    inline void setParameters(const WaveParameters &params) { m_params = params; initializeWaves(); }
+    const WaveParameters &parameters() const;
+    void setParameters(const WaveParameters &params);
+    void setBlendTime(float seconds);
+    void randomizeWaves();
+    inline void randomizeWaves(unsigned int seed) { srand(seed); randomizeWaves(); }
+    // takes the waves as they are now to be those at elapsed_time, so that
+    // freshly randomized waves rendered at t have moved on by t - elapsed_time
+    void setWaveTime(float elapsed_time);
+
+    // switches to new grid settings over the next frames, see WaterResources
+    const GridSettings &grid() const;
+    void setGrid(const GridSettings &grid);
+    // true until the mesh and normal map match the last setGrid()
+    bool gridPending() const;
+
+    // false if a GL object could not be created; the error has been printed
+    // and render() draws nothing
+    bool isValid() const;
 
     void render(float elapsed_time);
 
+    // packed geometric wave records as uploaded to the wave shader, see wavefunction.h
+    const float *geometricWaves() const;
+
 private:
-    struct Wave
-    {
-        Wave();
-        Wave(const WaveParameters &params);
-        WaveParameters params;
-    };
-
-    void initializeWaves();
-
-    Wave m_geo_waves[GEOMETRIC_WAVES], // geometric waves
-         m_nm_waves[NORMALMAP_WAVES]; // normal map waves
-    WaveParameters m_params;
-    unsigned int m_count;
-    GLuint m_vbo, m_normalmap, m_nmfbo;
-    QGLShaderProgram *m_waveprog, *m_nmprog;
+    void renderNormalMap();
+
+    WaterResources *m_shared;
+    GLuint m_nmfbo;
+    bool m_valid;
 };
 
 #endif // WATERENGINE_H
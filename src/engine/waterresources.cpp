@@ -0,0 +1,240 @@
+#include "waterresources.h"
+#include "shadercache.h"
+#include "glresources.h"
+#include <QtConcurrentRun>
+#include <iostream>
+
+#ifndef __APPLE__
+extern "C"
+{
+    void glBindBuffer (GLenum, GLuint);
+    void glDeleteBuffers (GLsizei, const GLuint *);
+    void glGenBuffers (GLsizei, GLuint *);
+    void glBufferData (GLenum, GLsizeiptr, const GLvoid *, GLenum);
+    void glBufferSubData (GLenum, GLintptr, GLsizeiptr, const GLvoid *);
+}
+#endif
+
+// Bytes of a new mesh uploaded per frame, about a millisecond of bus time
+#define MESH_UPLOAD_CHUNK (4 << 20)
+
+WaterResources::WaterResources(const QString &shader_dir, const GridSettings &grid)
+{
+    m_refs = 0;
+    m_valid = true;
+    m_nm_stale = true;
+
+    // seed random
+    srand(time(0));
+
+    // initialize waves
+    m_grid = m_requested = grid;
+    m_waves.setGrid(grid);
+    m_waves.randomize();
+    m_last_time = 0.f;
+
+    // the mesh is built in the background like any later one, until it is
+    // uploaded only the sky is drawn
+    m_vbo = 0;
+    m_count = 0;
+    m_building = false;
+    m_upload_vbo = 0;
+    m_uploaded = 0;
+
+    // normal map texture, rendered into by each engine's framebuffer
+    m_normalmap = 0;
+    m_levels = 0;
+    if (!createNormalMap(grid.texsize)) m_valid = false;
+
+    // shader programs, from shaders/ or the on-disk binary cache
+    m_shaders = new ShaderCache(shader_dir);
+    m_nmprog = m_waveprog = NULL;
+    buildPrograms();
+    if (!m_nmprog || !m_waveprog) m_valid = false;
+
+    updateGrid();
+}
+
+WaterResources::~WaterResources()
+{
+    if (m_building) m_build.waitForFinished();
+    GLResources::remove(GLResources::Buffer, m_upload_vbo);
+    glDeleteBuffers(1, &m_upload_vbo);
+    GLResources::remove(GLResources::Buffer, m_vbo);
+    glDeleteBuffers(1, &m_vbo);
+    GLResources::remove(GLResources::Texture, m_normalmap);
+    glDeleteTextures(1, &m_normalmap);
+    ShaderCache::destroy(m_waveprog);
+    ShaderCache::destroy(m_nmprog);
+    delete m_shaders;
+}
+
+QVector<Vector3> WaterResources::buildMesh(const GridSettings &grid)
+{
+    // build the base mesh, one quad per cell
+    int cells = grid.cells();
+    float unit = grid.spacing;
+    QVector<Vector3> vertices(cells * cells * 4);
+    Vector3 *v = vertices.data();
+    float x, z;
+    z = -grid.extent/2.f;
+    for (int i = 0; i < cells; i++) {
+        x = -grid.extent/2.f;
+        for (int j = 0; j < cells; j++) {
+            v->x = x;
+            v->y = 0.f;
+            v->z = z;
+            v++;
+            v->x = x;
+            v->y = 0.f;
+            v->z = z + unit;
+            v++;
+            v->x = x + unit;
+            v->y = 0.f;
+            v->z = z + unit;
+            v++;
+            v->x = x + unit;
+            v->y = 0.f;
+            v->z = z;
+            v++;
+            x += unit;
+        }
+        z += unit;
+    }
+    return vertices;
+}
+
+bool WaterResources::createNormalMap(int texsize)
+{
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // every mipmap level is rendered with only the waves it can resolve
+    int levels = 0;
+    for (int size = texsize; size > 0; size /= 2)
+        glTexImage2D(GL_TEXTURE_2D, levels++, GL_RGB, size, size, 0, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    GLResources::add(GLResources::Texture, texture, GLResources::textureBytes(texsize, texsize, 3, true), "normal map");
+
+    if (!GLResources::checkError("creating the normal map")) {
+        GLResources::remove(GLResources::Texture, texture);
+        glDeleteTextures(1, &texture);
+        return false;
+    }
+
+    GLResources::remove(GLResources::Texture, m_normalmap);
+    glDeleteTextures(1, &m_normalmap);
+    m_normalmap = texture;
+    m_levels = levels;
+    m_grid.texsize = texsize;
+    m_nm_stale = true;
+    return true;
+}
+
+void WaterResources::setGrid(const GridSettings &grid)
+{
+    if (grid.isValid()) m_requested = grid;
+}
+
+void WaterResources::updateGrid()
+{
+    if (m_building) {
+        if (!m_build.isFinished()) return;
+
+        if (!m_upload_vbo) {
+            if (!m_build_grid.sameMesh(m_requested)) {
+                // superseded while it was being built
+                m_building = false;
+            } else {
+                m_upload = m_build.result();
+                glGenBuffers(1, &m_upload_vbo);
+                glBindBuffer(GL_ARRAY_BUFFER, m_upload_vbo);
+                glBufferData(GL_ARRAY_BUFFER, m_upload.size() * sizeof(Vector3), NULL, GL_STATIC_DRAW);
+                glBindBuffer(GL_ARRAY_BUFFER, 0);
+                GLResources::add(GLResources::Buffer, m_upload_vbo, m_upload.size() * sizeof(Vector3), "mesh");
+                m_uploaded = 0;
+            }
+        }
+
+        if (m_upload_vbo) {
+            int bytes = m_upload.size() * sizeof(Vector3);
+            int chunk = qMin(MESH_UPLOAD_CHUNK, bytes - m_uploaded);
+            glBindBuffer(GL_ARRAY_BUFFER, m_upload_vbo);
+            glBufferSubData(GL_ARRAY_BUFFER, m_uploaded, chunk, (const char *)m_upload.constData() + m_uploaded);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            m_uploaded += chunk;
+            if (m_uploaded < bytes) return;
+
+            if (GLResources::checkError("uploading the mesh")) {
+                // complete, the next draw uses it
+                GLResources::remove(GLResources::Buffer, m_vbo);
+                glDeleteBuffers(1, &m_vbo);
+                m_vbo = m_upload_vbo;
+                m_count = m_upload.size();
+                m_grid.extent = m_build_grid.extent;
+                m_grid.spacing = m_build_grid.spacing;
+                // other contexts only see the new buffer after a flush here
+                glFlush();
+            } else {
+                // keep drawing the previous mesh, if there is one
+                GLResources::remove(GLResources::Buffer, m_upload_vbo);
+                glDeleteBuffers(1, &m_upload_vbo);
+                m_requested.extent = m_grid.extent;
+                m_requested.spacing = m_grid.spacing;
+                if (!m_vbo) m_valid = false;
+            }
+            m_upload_vbo = 0;
+            m_upload = QVector<Vector3>();
+            m_building = false;
+        }
+    }
+
+    if ((!m_vbo && m_valid) || !m_requested.sameMesh(m_grid)) {
+        m_build_grid = m_requested;
+        m_build = QtConcurrent::run(buildMesh, m_requested);
+        m_building = true;
+    } else if (m_requested.texsize != m_grid.texsize) {
+        if (!createNormalMap(m_requested.texsize)) m_requested.texsize = m_grid.texsize;
+    }
+
+    // waves picked from now on suit the new resolution
+    m_waves.setGrid(m_grid);
+}
+
+void WaterResources::buildPrograms()
+{
+    // shader program that generates the normal map
+    QGLShaderProgram *nmprog = m_shaders->program(QString(), "normalmap.frag");
+    // shader program that produces the final render
+    QGLShaderProgram *waveprog = m_shaders->program("wave.vert", "wave.frag");
+
+    // a broken edit while hot-reloading keeps the previous programs running
+    if (!nmprog || !waveprog) {
+        ShaderCache::destroy(nmprog);
+        ShaderCache::destroy(waveprog);
+        return;
+    }
+    ShaderCache::destroy(m_nmprog);
+    ShaderCache::destroy(m_waveprog);
+    m_nmprog = nmprog;
+    m_waveprog = waveprog;
+    m_nm_stale = true;
+}
+
+bool WaterResources::preparePrograms()
+{
+    if (m_shaders->reloadPending()) buildPrograms();
+    return m_nmprog && m_waveprog;
+}
+
+void WaterResources::update(float elapsed_time)
+{
+    if (elapsed_time == m_last_time) return;
+    m_waves.update(elapsed_time - m_last_time);
+    m_last_time = elapsed_time;
+    m_nm_stale = true;
+}
@@ -0,0 +1,95 @@
+#ifndef WATERRESOURCES_H
+#define WATERRESOURCES_H
+
+#include <qgl.h>
+#include <QGLShaderProgram>
+#include <QFuture>
+#include <QVector>
+
+#include "vector.h"
+#include "waveset.h"
+
+class ShaderCache;
+
+// The part of WaterEngine that every view of the same ocean can share: the
+// base mesh, the normal map texture, both shader programs and the waves.
+// Engines in contexts of one share group hold references to one instance,
+// the last of them deletes it. Framebuffers cannot be shared between
+// contexts, so each engine renders the normal map through its own.
+//
+// The grid settings can change while rendering. A new mesh is generated on
+// a worker thread and uploaded a chunk per frame into a buffer of its own,
+// and only replaces the one being drawn once it is complete, so no frame
+// waits for it or shows a partial mesh. A new normal map size just swaps in
+// a texture of that size, which is rendered before the next frame uses it.
+class WaterResources
+{
+public:
+    WaterResources(const QString &shader_dir, const GridSettings &grid);
+    ~WaterResources();
+
+    inline void ref() { m_refs++; }
+    // true when the last reference is gone and the caller should delete it
+    inline bool deref() { return --m_refs == 0; }
+
+    // false if a GL object could not be created; the error has been printed
+    inline bool isValid() const { return m_valid; }
+
+    inline WaveSet &waves() { return m_waves; }
+    inline const WaveSet &waves() const { return m_waves; }
+
+    // advances the waves to elapsed_time, once however many views render it
+    void update(float elapsed_time);
+    inline void setTime(float elapsed_time) { m_last_time = elapsed_time; }
+
+    // settings in use, and the ones to switch to as soon as they are ready
+    inline const GridSettings &grid() const { return m_grid; }
+    inline const GridSettings &requestedGrid() const { return m_requested; }
+    void setGrid(const GridSettings &grid);
+    inline bool gridPending() const { return m_valid && (!m_vbo || m_grid != m_requested); }
+    // moves a pending grid change along by at most one upload chunk, must be
+    // called every frame with a context of the share group current
+    void updateGrid();
+    // rebuilds the programs if a source changed, false while there are none
+    bool preparePrograms();
+
+    // set when the waves or programs changed since the normal map was rendered
+    inline bool normalMapStale() const { return m_nm_stale; }
+    inline void setNormalMapStale(bool stale) { m_nm_stale = stale; }
+
+    // 0 until the first mesh has been uploaded
+    inline GLuint vbo() const { return m_vbo; }
+    inline unsigned int vertexCount() const { return m_count; }
+    inline GLuint normalMap() const { return m_normalmap; }
+    inline int normalMapLevels() const { return m_levels; }
+    inline int normalMapSize() const { return m_grid.texsize; }
+    inline QGLShaderProgram *waveProgram() const { return m_waveprog; }
+    inline QGLShaderProgram *normalMapProgram() const { return m_nmprog; }
+
+private:
+    void buildPrograms();
+    bool createNormalMap(int texsize);
+
+    static QVector<Vector3> buildMesh(const GridSettings &grid);
+
+    int m_refs;
+    bool m_valid, m_nm_stale;
+    WaveSet m_waves;
+    float m_last_time;
+    unsigned int m_count;
+    int m_levels; // mipmap levels of the normal map
+    GLuint m_vbo, m_normalmap;
+    QGLShaderProgram *m_waveprog, *m_nmprog;
+    ShaderCache *m_shaders;
+
+    GridSettings m_grid, m_requested;
+    // mesh being built for m_build_grid, then uploaded into m_upload_vbo
+    bool m_building;
+    GridSettings m_build_grid;
+    QFuture< QVector<Vector3> > m_build;
+    QVector<Vector3> m_upload;
+    GLuint m_upload_vbo;
+    int m_uploaded; // bytes
+};
+
+#endif // WATERRESOURCES_H
@@ -0,0 +1,102 @@
+#include "wavefunction.h"
+#include "waveset.h"
+#include "simd.h"
+#include <vector>
+#include <algorithm>
+
+// Points between exact evaluations of the rotated sine and cosine in
+// gerstnerDisplaceGrid(). The error of the rotation grows about linearly,
+// by an ulp or two per step.
+#define GRID_RESEED 32
+
+Vector3 gerstnerDisplace(const float *waves, int count, float x, float z)
+{
+    Vector3 P(x, 0.f, z);
+    for (int i = 0; i < count * WAVE_FLOATS; i += WAVE_FLOATS) {
+        float A = waves[i] * waves[i+3];                                // Amplitude
+        float omega = 2.f * M_PI / waves[i];                            // Frequency
+        float phi = waves[i+2];                                         // Phase
+        float Qi = waves[i+1] / (omega * A * (float)GEOMETRIC_WAVES);   // Steepness
+
+        float term = omega * (waves[i+4] * x + waves[i+5] * z) + phi;
+        float C = cosf(term);
+        float S = sinf(term);
+        P.x += Qi * A * waves[i+4] * C;
+        P.y += A * S;
+        P.z += Qi * A * waves[i+5] * C;
+    }
+    return P;
+}
+
+// constants of four waves, laid out for float4 loads
+struct WaveGroup
+{
+    float kx[4], kz[4], phi[4];         // phase = kx * x + kz * z + phi
+    float ax[4], ay[4], az[4];          // displacement per cosine, sine, cosine
+    float cstep[4], sstep[4];           // rotation by one grid step along x
+};
+
+void gerstnerDisplaceGrid(const float *waves, int count, float x0, float z0, float dx, float dz,
+                          int nx, int nz, float *px, float *py, float *pz)
+{
+    if (nx <= 0 || nz <= 0) return;
+
+    // lanes past count stay silent
+    int groups = (count + 3) / 4;
+    std::vector<WaveGroup> g(groups, WaveGroup());
+    for (int w = 0; w < count; w++) {
+        const float *wave = waves + w * WAVE_FLOATS;
+        WaveGroup &c = g[w / 4];
+        int l = w % 4;
+        float A = wave[0] * wave[3];
+        float omega = 2.f * M_PI / wave[0];
+        float Qi = wave[1] / (omega * A * (float)GEOMETRIC_WAVES);
+        c.kx[l] = omega * wave[4];
+        c.kz[l] = omega * wave[5];
+        c.phi[l] = wave[2];
+        c.ax[l] = Qi * A * wave[4];
+        c.ay[l] = A;
+        c.az[l] = Qi * A * wave[5];
+        // in double, any error in the step accumulates along the row
+        double step = (double)c.kx[l] * dx;
+        c.cstep[l] = (float)cos(step);
+        c.sstep[l] = (float)sin(step);
+    }
+
+    // per point sums of every lane, reduced once the row is done
+    std::vector<float> acc(nx * 12);
+    for (int j = 0; j < nz; j++) {
+        float z = z0 + j * dz;
+        std::fill(acc.begin(), acc.end(), 0.f);
+
+        for (int k = 0; k < groups; k++) {
+            const WaveGroup &c = g[k];
+            float4 kx = float4::load(c.kx);
+            float4 base = float4::load(c.kz) * float4(z) + float4::load(c.phi);
+            float4 ax = float4::load(c.ax), ay = float4::load(c.ay), az = float4::load(c.az);
+            float4 cs = float4::load(c.cstep), ss = float4::load(c.sstep);
+
+            float4 S, C;
+            float *a = &acc[0];
+            for (int i = 0; i < nx; i++, a += 12) {
+                if (i % GRID_RESEED == 0) sincos(kx * float4(x0 + i * dx) + base, S, C);
+                (float4::load(a) + ax * C).store(a);
+                (float4::load(a + 4) + ay * S).store(a + 4);
+                (float4::load(a + 8) + az * C).store(a + 8);
+
+                // sin(p + step) and cos(p + step)
+                float4 s = S * cs + C * ss;
+                C = C * cs - S * ss;
+                S = s;
+            }
+        }
+
+        const float *a = &acc[0];
+        float *x = px + j * nx, *y = py + j * nx, *zz = pz + j * nx;
+        for (int i = 0; i < nx; i++, a += 12) {
+            x[i] = x0 + i * dx + ((a[0] + a[1]) + (a[2] + a[3]));
+            y[i] = (a[4] + a[5]) + (a[6] + a[7]);
+            zz[i] = z + ((a[8] + a[9]) + (a[10] + a[11]));
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef WAVEFUNCTION_H
+#define WAVEFUNCTION_H
+
+#include "vector.h"
+
+// Number of floats per packed wave record, matching WaveRecord and the layout
+// of the "waves" uniform arrays: wavelength, steepness, phase, kAmpOverLen, dir.x, dir.y
+#define WAVE_FLOATS 6
+
+// CPU version of the displacement loop of wave_function() in the wave vertex
+// shader. Returns the displaced position of the base mesh point (x, 0, z).
+Vector3 gerstnerDisplace(const float *waves, int count, float x, float z);
+
+// Same as gerstnerDisplace() for the nx x nz grid of points (x0 + i*dx, z0 + j*dz),
+// written as planar x, y and z arrays in rows of constant z. Along a row every
+// wave's phase grows by a constant, so its sine and cosine are advanced by a
+// rotation instead of being evaluated at each point, four waves at a time.
+// They are evaluated exactly every GRID_RESEED points to bound the drift.
+void gerstnerDisplaceGrid(const float *waves, int count, float x0, float z0, float dx, float dz,
+                          int nx, int nz, float *px, float *py, float *pz);
+
+#endif // WAVEFUNCTION_H
@@ -0,0 +1,256 @@
+#include "waveset.h"
+#include "wavespectrum.h"
+#include <algorithm>
+#include <iostream>
+
+#define GW GEOMETRIC_WAVES
+#define NMW NORMALMAP_WAVES
+
+// candidates drawn from the spectrum for both budgets
+#define SPECTRUM_WAVENUMBERS 32
+#define SPECTRUM_DIRECTIONS 16
+
+// world units per unit of uv in normalmap.frag: the texture covers uv 0..2
+// and repeats every 16 world units (texcoord * 0.125 in wave.frag)
+#define NM_WORLD_SCALE 8.f
+
+// shortest waves the mesh shows without faceting (four quads), and the
+// visible range of the normal map: from 16 texels, below which the
+// unfiltered texture only sparkles at viewing distance, up to one repeat
+#define GEO_MIN_WAVELENGTH(grid) (4.f * (grid).spacing)
+#define NM_MIN_WAVELENGTH(grid) (16.f * 2.f * NM_WORLD_SCALE / (grid).texsize)
+#define NM_MAX_WAVELENGTH (2.f * NM_WORLD_SCALE)
+
+namespace
+{
+    bool moreEnergy(const SpectrumComponent &a, const SpectrumComponent &b)
+    {
+        return a.energy() > b.energy();
+    }
+
+    bool longer(const SpectrumComponent &a, const SpectrumComponent &b)
+    {
+        return a.wavelength > b.wavelength;
+    }
+
+    struct SteeperThan
+    {
+        const std::vector<SpectrumComponent> &c;
+        SteeperThan(const std::vector<SpectrumComponent> &c) : c(c) {}
+        bool operator () (int a, int b) const { return c[a].slope() > c[b].slope(); }
+    };
+
+    struct LongerThan
+    {
+        const std::vector<SpectrumComponent> &c;
+        LongerThan(const std::vector<SpectrumComponent> &c) : c(c) {}
+        bool operator () (int a, int b) const { return c[a].wavelength > c[b].wavelength; }
+    };
+}
+
+GridSettings::GridSettings()
+{
+    extent = DIM;
+    spacing = UNIT;
+    texsize = TEXSIZE;
+}
+
+bool GridSettings::isValid() const
+{
+    if (spacing <= 0.f || extent < spacing || cells() > MAX_GRID_CELLS) {
+        std::cout << "error: The mesh needs 1 to " << MAX_GRID_CELLS << " cells per side, not "
+                  << extent << "/" << spacing << std::endl;
+        return false;
+    }
+    if (texsize < MIN_TEXSIZE || texsize > MAX_TEXSIZE || (texsize & (texsize - 1))) {
+        std::cout << "error: The normal map size must be a power of two from " << MIN_TEXSIZE
+                  << " to " << MAX_TEXSIZE << ", not " << texsize << std::endl;
+        return false;
+    }
+    return true;
+}
+
+WaveSet::WaveSet()
+{
+    m_params = defaultParameters();
+    m_blend = 1.f;
+    m_blend_time = 1.f;
+    for (int i = 0; i < GW; i++) {
+        m_scale[i] = 1.f;
+        m_amp[i] = 1.f;
+        m_geo[i].phase = 0.f;
+    }
+    for (int i = 0; i < NMW; i++) {
+        m_nm[i].phase = 0.f;
+        m_nm_omega[i] = 0.f;
+    }
+}
+
+WaveParameters WaveSet::defaultParameters()
+{
+    WaveParameters p;
+    p.wavelength = 10.f;
+    p.steepness = 0.8f;
+    p.kAmpOverLen = 0.02f;
+    p.speed = 0.15f;
+    p.wave_dir = Vector2(1.f, 0.8f).unit();
+    return p;
+}
+
+void WaveSet::randomize()
+{
+    // the range covers the normal map band and reaches well past the
+    // shortest wave the mesh can show, however short the peak is
+    float max_wavelength = fmaxf(fmaxf(2.f * m_params.wavelength, NM_MAX_WAVELENGTH),
+                                 2.f * GEO_MIN_WAVELENGTH(m_grid));
+    WaveSpectrum spectrum(m_params.wavelength, m_params.wave_dir);
+    std::vector<SpectrumComponent> c = spectrum.sample(NM_MIN_WAVELENGTH(m_grid),
+            max_wavelength, SPECTRUM_WAVENUMBERS, SPECTRUM_DIRECTIONS);
+    if (c.empty()) return;
+    std::vector<bool> taken(c.size(), false);
+
+    // geometric budget: the most energetic components the mesh can resolve
+    std::sort(c.begin(), c.end(), moreEnergy);
+    std::vector<SpectrumComponent> geo;
+    for (int j = 0; j < (int)c.size() && (int)geo.size() < GW; j++) {
+        if (c[j].wavelength < GEO_MIN_WAVELENGTH(m_grid)) continue;
+        taken[j] = true;
+        geo.push_back(c[j]);
+    }
+    // jitter can leave too few long enough: the longest of the others
+    if ((int)geo.size() < GW) {
+        std::vector<int> rest;
+        for (int j = 0; j < (int)c.size(); j++) if (!taken[j]) rest.push_back(j);
+        std::sort(rest.begin(), rest.end(), LongerThan(c));
+        for (int i = 0; i < (int)rest.size() && (int)geo.size() < GW; i++) {
+            taken[rest[i]] = true;
+            geo.push_back(c[rest[i]]);
+        }
+    }
+    for (int i = 0; (int)geo.size() < GW; i++) geo.push_back(geo[i]);
+
+    // both sets are stored longest first, so the shaders can stop at the
+    // first wave that is too short to show at their resolution
+    std::sort(geo.begin(), geo.end(), longer);
+    float wl_sum = 0.f, amp_sum = 0.f;
+    for (int i = 0; i < GW; i++) {
+        m_scale[i] = geo[i].wavelength / m_params.wavelength;
+        m_amp[i] = geo[i].amplitude / geo[i].wavelength;
+        m_geo[i].dir = geo[i].dir;
+        m_geo[i].phase = frandf() * 2.f * M_PI;
+        wl_sum += geo[i].wavelength;
+        amp_sum += geo[i].amplitude;
+    }
+
+    // relative to a set of equally steep waves, so the summed amplitude at
+    // the same kAmpOverLen stays what it was with the old uniform waves
+    float norm = amp_sum > 0.f ? wl_sum / amp_sum : 1.f;
+    for (int i = 0; i < GW; i++) {
+        m_amp[i] *= norm;
+        m_from[i] = m_to[i] = m_current[i] = derive(i, m_params);
+    }
+    m_blend = 1.f;
+
+    // normal map budget: the steepest remaining components the texture can
+    // resolve. Slope rather than energy, since they only shade.
+    std::vector<int> order;
+    for (int j = 0; j < (int)c.size(); j++)
+        if (!taken[j] && c[j].wavelength <= NM_MAX_WAVELENGTH) order.push_back(j);
+    std::sort(order.begin(), order.end(), SteeperThan(c));
+    // a small texture leaves a narrow band: then the shortest of the others,
+    // and as a last resort the same components again
+    if ((int)order.size() < NMW) {
+        std::vector<int> rest;
+        for (int j = 0; j < (int)c.size(); j++)
+            if (!taken[j] && c[j].wavelength > NM_MAX_WAVELENGTH) rest.push_back(j);
+        std::sort(rest.begin(), rest.end(), LongerThan(c));
+        for (int i = (int)rest.size() - 1; i >= 0 && (int)order.size() < NMW; i--) order.push_back(rest[i]);
+    }
+    if (order.empty()) order.push_back(0);
+    std::vector<SpectrumComponent> nm;
+    for (int i = 0; i < NMW; i++) nm.push_back(c[order[i % order.size()]]);
+    std::sort(nm.begin(), nm.end(), longer);
+
+    float slope_sum = 0.f;
+    for (int i = 0; i < NMW; i++) {
+        const SpectrumComponent &w = nm[i];
+        m_nm[i].wavelength = w.wavelength / NM_WORLD_SCALE;
+        m_nm[i].dir = w.dir;
+        m_nm[i].steepness = 5.f*(frandf() * 2.f + 1.f);
+        m_nm[i].kAmpOverLen = w.amplitude / w.wavelength;
+        m_nm[i].phase = frandf() * 2.f * M_PI;
+        m_nm_omega[i] = sqrtf(9.81f * 2.f*M_PI/w.wavelength);
+        slope_sum += m_nm[i].kAmpOverLen;
+    }
+
+    // keep the overall normal map strength of the old constant 0.03 per wave
+    if (slope_sum > 0.f)
+        for (int i = 0; i < NMW; i++) m_nm[i].kAmpOverLen *= NMW * 0.03f / slope_sum;
+
+    apply();
+}
+
+WaveSet::Derived WaveSet::derive(int i, const WaveParameters &p) const
+{
+    Derived d;
+    float wl = p.wavelength * m_scale[i];
+    d.wavelength = wl;
+    d.steepness = p.steepness;
+    d.speed = sqrt(9.81f * 2.f*M_PI/wl)*wl*p.speed; 
+    d.kAmpOverLen = p.kAmpOverLen * m_amp[i];
+    return d;
+}
+
+void WaveSet::setParameters(const WaveParameters &params)
+{
+    // blend from wherever a running blend currently is
+    m_params = params;
+    for (int i = 0; i < GW; i++) {
+        m_from[i] = m_current[i];
+        m_to[i] = derive(i, params);
+    }
+    m_blend = 0.f;
+    update(0.f);
+}
+
+void WaveSet::update(float dt)
+{
+    if (dt < 0.f) dt = 0.f;
+
+    if (m_blend < 1.f) {
+        m_blend = m_blend_time > 0.f ? fminf(1.f, m_blend + dt / m_blend_time) : 1.f;
+        float t = m_blend * m_blend * (3.f - 2.f * m_blend);
+        for (int i = 0; i < GW; i++) {
+            const Derived &a = m_from[i], &b = m_to[i];
+            Derived &c = m_current[i];
+            c.wavelength = a.wavelength + (b.wavelength - a.wavelength) * t;
+            c.steepness = a.steepness + (b.steepness - a.steepness) * t;
+            c.speed = a.speed + (b.speed - a.speed) * t;
+            c.kAmpOverLen = a.kAmpOverLen + (b.kAmpOverLen - a.kAmpOverLen) * t;
+        }
+    }
+
+    // integrate phases instead of evaluating phi * time in the shaders, so a
+    // new speed only changes how fast the pattern moves from here on. Keeping
+    // them wrapped also avoids losing precision on long runs.
+    for (int i = 0; i < GW; i++) {
+        float omega = 2.f * M_PI / m_current[i].wavelength;
+        m_geo[i].phase = fmodf(m_geo[i].phase + m_current[i].speed * omega * dt, 2.f * M_PI);
+    }
+    // normal map waves follow the same dispersion, sqrt(g k) scaled by speed
+    for (int i = 0; i < NMW; i++) {
+        float rate = 2.f * M_PI * m_params.speed * m_nm_omega[i];
+        m_nm[i].phase = fmodf(m_nm[i].phase + rate * dt, 2.f * M_PI);
+    }
+
+    apply();
+}
+
+void WaveSet::apply()
+{
+    for (int i = 0; i < GW; i++) {
+        m_geo[i].wavelength = m_current[i].wavelength;
+        m_geo[i].steepness = m_current[i].steepness;
+        m_geo[i].kAmpOverLen = m_current[i].kAmpOverLen;
+    }
+}
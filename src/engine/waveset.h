@@ -0,0 +1,117 @@
+#ifndef WAVESET_H
+#define WAVESET_H
+
+#include "vector.h"
+
+#define GEOMETRIC_WAVES 4
+#define NORMALMAP_WAVES 50
+
+// Default surface mesh extent and spacing and normal map size, see GridSettings
+#define DIM 300
+#define UNIT 1.f
+#define TEXSIZE 256
+
+// Limits of GridSettings::isValid(); 2048^2 quads are 16M vertices, close
+// to 200 MB of mesh
+#define MAX_GRID_CELLS 2048
+#define MIN_TEXSIZE 16
+#define MAX_TEXSIZE 4096
+
+// Resolution of the surface, shared by the renderers
+struct GridSettings
+{
+    GridSettings();
+
+    float extent;   // edge length of the square base mesh
+    float spacing;  // distance between neighbouring mesh vertices
+    int texsize;    // normal map edge in texels, a power of two
+
+    inline int cells() const { return (int)(extent / spacing + 0.5f); }
+    // prints what is wrong if the settings cannot be rendered
+    bool isValid() const;
+    inline bool sameMesh(const GridSettings &g) const { return extent == g.extent && spacing == g.spacing; }
+    inline bool operator == (const GridSettings &g) const { return sameMesh(g) && texsize == g.texsize; }
+    inline bool operator != (const GridSettings &g) const { return !(*this == g); }
+};
+
+struct WaveParameters
+{
+    float wavelength;
+    float steepness;
+    float speed;
+    float kAmpOverLen;
+    Vector2 wave_dir; 
+};
+
+// One wave as laid out in the "waves" uniform arrays. The phase is
+// accumulated on the CPU so speed changes never make the surface jump.
+struct WaveRecord
+{
+    float wavelength;
+    float steepness;
+    float phase;
+    float kAmpOverLen;
+    Vector2 dir;
+};
+
+// The geometric and normal map waves of one surface. randomize() samples a
+// directional wind sea spectrum (see wavespectrum.h) around the wavelength
+// and wave_dir parameters. The most energetic components the mesh can show
+// become the geometric waves and the steepest of the rest the normal map
+// waves. That random part (relative wavelength and amplitude, direction) is
+// drawn once; changing the parameters afterwards only recomputes the derived
+// per-wave values and blends towards them over blendTime() seconds.
+//
+// Both sets are ordered longest wave first, which the shaders rely on to end
+// their loops at the first wave below the pixel or texel footprint.
+class WaveSet
+{
+public:
+    WaveSet();
+
+    static WaveParameters defaultParameters();
+
+    void randomize();
+
+    // resolution the next randomize() picks waves for, so none are shorter
+    // than the mesh or normal map can show
+    inline void setGrid(const GridSettings &grid) { m_grid = grid; }
+
+    inline const WaveParameters &parameters() const { return m_params; }
+    void setParameters(const WaveParameters &params);
+
+    inline float blendTime() const { return m_blend_time; }
+    inline void setBlendTime(float seconds) { m_blend_time = seconds; }
+
+    // advance phases and any running blend by dt seconds
+    void update(float dt);
+
+    inline const WaveRecord *geometric() const { return m_geo; }
+    inline const WaveRecord *normalMap() const { return m_nm; }
+
+private:
+    struct Derived
+    {
+        float wavelength;
+        float steepness;
+        float speed;
+        float kAmpOverLen;
+    };
+
+    Derived derive(int i, const WaveParameters &p) const;
+    void apply();
+
+    WaveParameters m_params;
+    GridSettings m_grid;
+
+    float m_scale[GEOMETRIC_WAVES]; // wavelength of each geometric wave relative to the peak
+    float m_amp[GEOMETRIC_WAVES]; // kAmpOverLen of each geometric wave relative to the parameter
+    Derived m_from[GEOMETRIC_WAVES], m_to[GEOMETRIC_WAVES], m_current[GEOMETRIC_WAVES];
+    float m_blend, m_blend_time;
+
+    float m_nm_omega[NORMALMAP_WAVES]; // deep water angular frequency of each normal map wave
+
+    WaveRecord m_geo[GEOMETRIC_WAVES], m_nm[NORMALMAP_WAVES];
+};
+
+#endif // WAVESET_H
@@ -0,0 +1,43 @@
+#include "wavespectrum.h"
+
+WaveSpectrum::WaveSpectrum(float peak_wavelength, const Vector2 &wind, float spread)
+{
+    m_peak_k = 2.f * M_PI / peak_wavelength;
+    m_wind = wind.unit();
+    m_spread = spread;
+
+    // cos^2s(theta/2) integrates to 2 sqrt(pi) gamma(s + 1/2) / gamma(s + 1)
+    m_norm = tgammaf(m_spread + 1.f) / (2.f * sqrtf(M_PI) * tgammaf(m_spread + 0.5f));
+}
+
+float WaveSpectrum::density(float wavelength, const Vector2 &dir) const
+{
+    // F(k) ~ k^-4 exp(-5/4 (kp/k)^2) per unit area of wavenumber space; times
+    // k^2 for polar cells of constant log k and angle
+    float k = 2.f * M_PI / wavelength;
+    float r = m_peak_k / k;
+    float radial = r * r * expf(-1.25f * r * r);
+
+    float c = sqrtf(fmaxf(0.f, 0.5f * (1.f + dir.dot(m_wind)))); // cos(theta/2)
+    return radial * m_norm * powf(c, 2.f * m_spread);
+}
+
+std::vector<SpectrumComponent> WaveSpectrum::sample(float min_wavelength, float max_wavelength,
+                                                    int nk, int ntheta) const
+{
+    std::vector<SpectrumComponent> components;
+    float lk0 = logf(2.f * M_PI / max_wavelength), lk1 = logf(2.f * M_PI / min_wavelength);
+    float dlk = (lk1 - lk0) / nk, dtheta = 2.f * M_PI / ntheta;
+    float wind = m_wind.toAngle();
+
+    for (int i = 0; i < nk; i++) {
+        for (int j = 0; j < ntheta; j++) {
+            SpectrumComponent c;
+            c.wavelength = 2.f * M_PI / expf(lk0 + (i + frandf()) * dlk);
+            c.dir = Vector2::fromAngle(wind + (j + frandf() - 0.5f * ntheta) * dtheta);
+            c.amplitude = sqrtf(2.f * density(c.wavelength, c.dir) * dlk * dtheta);
+            components.push_back(c);
+        }
+    }
+    return components;
+}
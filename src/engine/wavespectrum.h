@@ -0,0 +1,40 @@
+#ifndef WAVESPECTRUM_H
+#define WAVESPECTRUM_H
+
+#include <vector>
+#include "vector.h"
+
+// One sinusoid drawn from the spectrum, amplitude in world units
+struct SpectrumComponent
+{
+    float wavelength;
+    float amplitude;
+    Vector2 dir;
+
+    inline float energy() const { return 0.5f * amplitude * amplitude; }
+    inline float slope() const { return 2.f * M_PI / wavelength * amplitude; }
+};
+
+// Directional wind sea: a Pierson-Moskowitz spectrum around the peak
+// wavelength, spread around the wind direction with cos^2s(theta/2). Only the
+// shape matters to WaveSet, the absolute energy is arbitrary.
+class WaveSpectrum
+{
+public:
+    WaveSpectrum(float peak_wavelength, const Vector2 &wind, float spread = 4.f);
+
+    // energy density per unit log wavenumber and radian
+    float density(float wavelength, const Vector2 &dir) const;
+
+    // one component per cell of a polar grid with nk log-spaced wavenumbers
+    // between the two wavelengths and ntheta directions, jittered with rand()
+    std::vector<SpectrumComponent> sample(float min_wavelength, float max_wavelength,
+                                          int nk, int ntheta) const;
+
+private:
+    float m_peak_k;
+    Vector2 m_wind;
+    float m_spread, m_norm;
+};
+
+#endif // WAVESPECTRUM_H
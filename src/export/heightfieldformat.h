@@ -0,0 +1,45 @@
+#ifndef HEIGHTFIELDFORMAT_H
+#define HEIGHTFIELDFORMAT_H
+
+#include <stdint.h>
+
+// Layout of the .whf height field time series written by HeightFieldWriter.
+//
+// A file is one HeightFieldHeader followed by any number of frames. Each
+// frame is a HeightFieldFrame header followed by its payload. Every sample
+// has three channels stored planar: height, x displacement and z
+// displacement, each quantized to 16 bits as offset + q * scale with a
+// per-frame, per-channel scale and offset.
+//
+// Keyframes store the quantized values as raw uint16. The other frames
+// store q - q_previous per sample, wrapped to 16 bits, zigzag mapped and
+// written as little-endian base-128 varints. A keyframe is written every
+// keyframe_interval frames so any frame can be decoded from the keyframe
+// before it. All fields are little-endian.
+
+#define HF_MAGIC 0x46485357 // "WSHF"
+#define HF_VERSION 1
+#define HF_CHANNELS 3
+
+struct HeightFieldHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t nx, nz;            // samples along x and z
+    float x0, z0, x1, z1;       // sampled region, inclusive
+    float dt;                   // nominal time between frames
+    uint32_t keyframe_interval;
+    uint32_t reserved[6];
+};
+
+struct HeightFieldFrame
+{
+    uint32_t size;              // payload bytes following this header
+    uint32_t index;
+    uint32_t keyframe;
+    float time;
+    float scale[HF_CHANNELS];
+    float offset[HF_CHANNELS];
+};
+
+#endif // HEIGHTFIELDFORMAT_H
@@ -0,0 +1,139 @@
+#include "heightfieldreader.h"
+#include <iostream>
+#include <string.h>
+
+HeightFieldReader::HeightFieldReader()
+{
+    m_data = NULL;
+    m_size = 0;
+    m_frames = 0;
+    m_current = -1;
+    m_offset = m_next = 0;
+    memset(&m_header, 0, sizeof(m_header));
+}
+
+HeightFieldReader::~HeightFieldReader()
+{
+    close();
+}
+
+bool HeightFieldReader::open(const QString &path)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        std::cout << "error: Cannot open height field file " << qPrintable(path) << std::endl;
+        return false;
+    }
+    m_size = m_file.size();
+    if (m_size < (qint64)sizeof(HeightFieldHeader) || !(m_data = m_file.map(0, m_size))) {
+        std::cout << "error: Cannot map height field file " << qPrintable(path) << std::endl;
+        close();
+        return false;
+    }
+
+    memcpy(&m_header, m_data, sizeof(m_header));
+    if (m_header.magic != HF_MAGIC || m_header.version != HF_VERSION ||
+        m_header.nx < 2 || m_header.nz < 2 || m_header.keyframe_interval == 0) {
+        std::cout << "error: " << qPrintable(path) << " is not a height field file" << std::endl;
+        close();
+        return false;
+    }
+
+    // hop over the frame headers once to index the keyframes. A frame cut
+    // short by an interrupted writer ends the series.
+    qint64 offset = sizeof(HeightFieldHeader);
+    HeightFieldFrame frame;
+    while (frameAt(offset, &frame)) {
+        bool key = (m_frames % m_header.keyframe_interval) == 0;
+        if (frame.index != (uint32_t)m_frames || (bool)frame.keyframe != key) break;
+        if (key) m_keyframes.append(offset);
+        offset += sizeof(HeightFieldFrame) + frame.size;
+        m_frames++;
+    }
+
+    m_quantized.resize(sampleCount() * HF_CHANNELS);
+    return true;
+}
+
+void HeightFieldReader::close()
+{
+    if (m_data) m_file.unmap((uchar *)m_data);
+    m_file.close();
+    m_data = NULL;
+    m_size = 0;
+    m_frames = 0;
+    m_current = -1;
+    m_keyframes.clear();
+}
+
+bool HeightFieldReader::frameAt(qint64 offset, HeightFieldFrame *frame) const
+{
+    // varint payloads leave later headers at any byte offset
+    if (offset + (qint64)sizeof(HeightFieldFrame) > m_size) return false;
+    memcpy(frame, m_data + offset, sizeof(HeightFieldFrame));
+    return offset + (qint64)sizeof(HeightFieldFrame) + frame->size <= m_size;
+}
+
+bool HeightFieldReader::decode(const HeightFieldFrame &frame, const uchar *payload)
+{
+    int count = sampleCount() * HF_CHANNELS;
+    const uchar *p = payload;
+    const uchar *end = p + frame.size;
+    uint16_t *q = m_quantized.data();
+
+    if (frame.keyframe) {
+        if (frame.size != count * sizeof(uint16_t)) return false;
+        memcpy(q, p, frame.size);
+        return true;
+    }
+
+    for (int k = 0; k < count; k++) {
+        uint32_t zz = 0;
+        int shift = 0;
+        do {
+            if (p == end || shift > 14) return false;
+            zz |= (uint32_t)(*p & 0x7f) << shift;
+            shift += 7;
+        } while (*p++ & 0x80);
+        uint16_t d = (zz & 1) ? ~(uint16_t)(zz >> 1) : (uint16_t)(zz >> 1);
+        q[k] += d;
+    }
+    return p == end;
+}
+
+bool HeightFieldReader::readFrame(int index, float *height, float *dx, float *dz, float *time)
+{
+    if (index < 0 || index >= m_frames) return false;
+
+    // continue from the last decoded frame when it is in the same interval
+    int interval = m_header.keyframe_interval;
+    if (m_current < 0 || index < m_current || index / interval != m_current / interval) {
+        m_current = (index / interval) * interval - 1;
+        m_next = m_keyframes[index / interval];
+    }
+
+    HeightFieldFrame frame;
+    while (m_current < index) {
+        if (!frameAt(m_next, &frame) || !decode(frame, m_data + m_next + sizeof(HeightFieldFrame))) {
+            m_current = -1;
+            return false;
+        }
+        m_offset = m_next;
+        m_next += sizeof(HeightFieldFrame) + frame.size;
+        m_current++;
+    }
+    frameAt(m_offset, &frame);
+
+    int n = sampleCount();
+    float *out[HF_CHANNELS] = { height, dx, dz };
+    for (int c = 0; c < HF_CHANNELS; c++) {
+        if (!out[c]) continue;
+        const uint16_t *q = m_quantized.constData() + c * n;
+        float scale = frame.scale[c], offset = frame.offset[c];
+        for (int k = 0; k < n; k++) out[c][k] = offset + q[k] * scale;
+    }
+    if (time) *time = frame.time;
+    return true;
+}
@@ -0,0 +1,49 @@
+#ifndef HEIGHTFIELDREADER_H
+#define HEIGHTFIELDREADER_H
+
+#include <QFile>
+#include <QVector>
+
+#include "heightfieldformat.h"
+
+// Random access to a .whf file written by HeightFieldWriter. The file is
+// memory mapped and only the keyframe offsets are indexed on open, so
+// reading frame i decodes at most one keyframe interval. Sequential reads
+// continue from the previously decoded frame.
+class HeightFieldReader
+{
+public:
+    HeightFieldReader();
+    ~HeightFieldReader();
+
+    bool open(const QString &path);
+    void close();
+
+    inline const HeightFieldHeader &header() const { return m_header; }
+    inline int frameCount() const { return m_frames; }
+    inline int sampleCount() const { return m_header.nx * m_header.nz; }
+
+    // Any of the output arrays may be NULL; each holds nx * nz floats, x fastest
+    bool readFrame(int index, float *height, float *dx, float *dz, float *time = NULL);
+
+private:
+    // copies the header at offset, which need not be aligned, and checks
+    // that its payload is in the file
+    bool frameAt(qint64 offset, HeightFieldFrame *frame) const;
+    bool decode(const HeightFieldFrame &frame, const uchar *payload);
+
+    QFile m_file;
+    const uchar *m_data;
+    qint64 m_size;
+
+    HeightFieldHeader m_header;
+    int m_frames;
+    QVector<qint64> m_keyframes;
+
+    // last decoded frame
+    QVector<uint16_t> m_quantized;
+    int m_current;
+    qint64 m_offset, m_next;
+};
+
+#endif // HEIGHTFIELDREADER_H
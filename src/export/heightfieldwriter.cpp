@@ -0,0 +1,182 @@
+#include "heightfieldwriter.h"
+#include "wavefunction.h"
+#include <iostream>
+#include <string.h>
+
+HeightFieldRegion::HeightFieldRegion()
+{
+    x0 = z0 = -50.f;
+    x1 = z1 = 50.f;
+    nx = nz = 256;
+}
+
+HeightFieldWriter::HeightFieldWriter(QObject *parent) : QThread(parent)
+{
+    m_frames = 0;
+    m_finished = false;
+}
+
+HeightFieldWriter::~HeightFieldWriter()
+{
+    finish();
+}
+
+bool HeightFieldWriter::open(const QString &path, const HeightFieldRegion &region, float dt)
+{
+    if (region.nx < 2 || region.nz < 2) {
+        std::cout << "error: Height field needs at least 2x2 samples" << std::endl;
+        return false;
+    }
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::cout << "error: Cannot open height field file " << qPrintable(path) << std::endl;
+        return false;
+    }
+
+    m_region = region;
+    m_frames = 0;
+    m_finished = false;
+
+    int n = region.nx * region.nz;
+    m_samples.resize(n * HF_CHANNELS);
+    m_quantized.resize(n * HF_CHANNELS);
+    m_previous.resize(n * HF_CHANNELS);
+    // worst case for a delta frame is 3 varint bytes per value
+    m_payload.reserve(n * HF_CHANNELS * 3);
+
+    HeightFieldHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = HF_MAGIC;
+    header.version = HF_VERSION;
+    header.nx = region.nx;
+    header.nz = region.nz;
+    header.x0 = region.x0;
+    header.z0 = region.z0;
+    header.x1 = region.x1;
+    header.z1 = region.z1;
+    header.dt = dt;
+    header.keyframe_interval = HF_KEYFRAME_INTERVAL;
+    m_file.write((const char *)&header, sizeof(header));
+
+    start();
+    return true;
+}
+
+void HeightFieldWriter::push(float time, const float *waves, int count)
+{
+    Step step;
+    step.time = time;
+    step.waves.resize(count * WAVE_FLOATS);
+    memcpy(step.waves.data(), waves, count * WAVE_FLOATS * sizeof(float));
+
+    QMutexLocker lock(&m_mutex);
+    if (m_finished) return;
+    while (m_queue.size() >= HF_QUEUE_SIZE) m_notfull.wait(&m_mutex);
+    m_queue.enqueue(step);
+    m_notempty.wakeOne();
+}
+
+void HeightFieldWriter::finish()
+{
+    if (!isRunning()) return;
+
+    m_mutex.lock();
+    m_finished = true;
+    m_notempty.wakeOne();
+    m_mutex.unlock();
+
+    wait();
+    m_file.close();
+}
+
+void HeightFieldWriter::run()
+{
+    for (;;) {
+        m_mutex.lock();
+        while (m_queue.isEmpty() && !m_finished) m_notempty.wait(&m_mutex);
+        if (m_queue.isEmpty()) {
+            m_mutex.unlock();
+            break;
+        }
+        Step step = m_queue.dequeue();
+        m_notfull.wakeOne();
+        m_mutex.unlock();
+
+        write(step);
+    }
+}
+
+static inline void putVarint(QByteArray &out, uint32_t v)
+{
+    while (v >= 0x80) {
+        out.append((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.append((char)v);
+}
+
+void HeightFieldWriter::write(const Step &step)
+{
+    const HeightFieldRegion &r = m_region;
+    int n = r.nx * r.nz;
+    int count = step.waves.size() / WAVE_FLOATS;
+
+    // sample the surface, planar channels
+    float *h = m_samples.data();
+    float *dx = h + n;
+    float *dz = dx + n;
+    float sx = (r.x1 - r.x0) / (r.nx - 1), sz = (r.z1 - r.z0) / (r.nz - 1);
+    gerstnerDisplaceGrid(step.waves.constData(), count, r.x0, r.z0, sx, sz, r.nx, r.nz, dx, h, dz);
+    for (int j = 0; j < r.nz; j++) {
+        float z = r.z0 + j * sz;
+        for (int i = 0; i < r.nx; i++) {
+            int k = j * r.nx + i;
+            dx[k] -= r.x0 + i * sx;
+            dz[k] -= z;
+        }
+    }
+
+    HeightFieldFrame frame;
+    frame.index = m_frames;
+    frame.keyframe = (m_frames % HF_KEYFRAME_INTERVAL) == 0;
+    frame.time = step.time;
+
+    // quantize each channel against its own range in this frame
+    uint16_t *q = m_quantized.data();
+    for (int c = 0; c < HF_CHANNELS; c++) {
+        const float *v = m_samples.constData() + c * n;
+        float lo = v[0], hi = v[0];
+        for (int k = 1; k < n; k++) {
+            lo = fminf(lo, v[k]);
+            hi = fmaxf(hi, v[k]);
+        }
+        float scale = (hi - lo) / 65535.f;
+        float inv = scale > 0.f ? 1.f / scale : 0.f;
+        frame.scale[c] = scale;
+        frame.offset[c] = lo;
+        for (int k = 0; k < n; k++) {
+            float t = (v[k] - lo) * inv + 0.5f;
+            q[c * n + k] = (uint16_t)fminf(t, 65535.f);
+        }
+    }
+
+    m_payload.clear();
+    if (frame.keyframe) {
+        m_payload.append((const char *)q, n * HF_CHANNELS * sizeof(uint16_t));
+    } else {
+        const uint16_t *p = m_previous.constData();
+        for (int k = 0; k < n * HF_CHANNELS; k++) {
+            // wraps modulo 2^16, then zigzag so small negative steps stay short
+            uint16_t d = q[k] - p[k];
+            uint32_t zz = (d & 0x8000) ? ((uint32_t)(uint16_t)~d << 1) | 1 : (uint32_t)d << 1;
+            putVarint(m_payload, zz);
+        }
+    }
+    frame.size = m_payload.size();
+
+    m_file.write((const char *)&frame, sizeof(frame));
+    m_file.write(m_payload);
+    m_previous.swap(m_quantized);
+    m_frames++;
+}
@@ -0,0 +1,70 @@
+#ifndef HEIGHTFIELDWRITER_H
+#define HEIGHTFIELDWRITER_H
+
+#include <QThread>
+#include <QFile>
+#include <QQueue>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+
+#include "heightfieldformat.h"
+
+// Number of timesteps that may wait for the writer thread before push() blocks
+#define HF_QUEUE_SIZE 16
+#define HF_KEYFRAME_INTERVAL 60
+
+struct HeightFieldRegion
+{
+    HeightFieldRegion();
+
+    float x0, z0, x1, z1;
+    int nx, nz;
+};
+
+// Samples the displaced surface over a regular grid and streams it to disk as
+// a quantized, delta-encoded time series (see heightfieldformat.h). Only the
+// wave constants and time are queued; sampling, quantization and encoding all
+// happen on the writer thread, which keeps a single previous frame around, so
+// memory use does not depend on the length of the run.
+class HeightFieldWriter : public QThread
+{
+public:
+    HeightFieldWriter(QObject *parent = 0);
+    ~HeightFieldWriter();
+
+    bool open(const QString &path, const HeightFieldRegion &region, float dt);
+    void push(float time, const float *waves, int count);
+    void finish();
+
+    inline int frameCount() const { return m_frames; }
+
+protected:
+    void run();
+
+private:
+    struct Step
+    {
+        float time;
+        QVector<float> waves;
+    };
+
+    void write(const Step &step);
+
+    QFile m_file;
+    HeightFieldRegion m_region;
+    int m_frames;
+    bool m_finished;
+
+    QQueue<Step> m_queue;
+    QMutex m_mutex;
+    QWaitCondition m_notempty, m_notfull;
+
+    // writer thread state
+    QVector<float> m_samples;
+    QVector<uint16_t> m_quantized, m_previous;
+    QByteArray m_payload;
+};
+
+#endif // HEIGHTFIELDWRITER_H
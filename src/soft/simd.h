@@ -0,0 +1,214 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <math.h>
+
+// Four-wide float vector for the software renderer. Uses SSE2 where it is
+// available and falls back to plain loops elsewhere. Comparisons return lane
+// masks to be used with select(), any() and all().
+//
+//     float4 x = float4::load(p);
+//     float4 y = select(x < float4(0.f), -x, x);
+//
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+
+struct float4
+{
+    __m128 v;
+
+    float4() {}
+    float4(__m128 v) : v(v) {}
+    float4(float s) : v(_mm_set1_ps(s)) {}
+    float4(float a, float b, float c, float d) : v(_mm_setr_ps(a, b, c, d)) {}
+
+    static float4 load(const float *p) { return _mm_loadu_ps(p); }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+    float operator [] (int i) const { float f[4]; store(f); return f[i]; }
+
+    float4 operator - () const { return _mm_sub_ps(_mm_setzero_ps(), v); }
+    float4 operator + (const float4 &b) const { return _mm_add_ps(v, b.v); }
+    float4 operator - (const float4 &b) const { return _mm_sub_ps(v, b.v); }
+    float4 operator * (const float4 &b) const { return _mm_mul_ps(v, b.v); }
+    float4 operator / (const float4 &b) const { return _mm_div_ps(v, b.v); }
+    float4 &operator += (const float4 &b) { v = _mm_add_ps(v, b.v); return *this; }
+    float4 &operator -= (const float4 &b) { v = _mm_sub_ps(v, b.v); return *this; }
+    float4 &operator *= (const float4 &b) { v = _mm_mul_ps(v, b.v); return *this; }
+
+    float4 operator < (const float4 &b) const { return _mm_cmplt_ps(v, b.v); }
+    float4 operator <= (const float4 &b) const { return _mm_cmple_ps(v, b.v); }
+    float4 operator > (const float4 &b) const { return _mm_cmpgt_ps(v, b.v); }
+    float4 operator >= (const float4 &b) const { return _mm_cmpge_ps(v, b.v); }
+    float4 operator == (const float4 &b) const { return _mm_cmpeq_ps(v, b.v); }
+    float4 operator & (const float4 &b) const { return _mm_and_ps(v, b.v); }
+    float4 operator | (const float4 &b) const { return _mm_or_ps(v, b.v); }
+};
+
+inline float4 min(const float4 &a, const float4 &b) { return _mm_min_ps(a.v, b.v); }
+inline float4 max(const float4 &a, const float4 &b) { return _mm_max_ps(a.v, b.v); }
+inline float4 sqrt(const float4 &a) { return _mm_sqrt_ps(a.v); }
+inline float4 select(const float4 &mask, const float4 &a, const float4 &b)
+{
+    return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+inline int movemask(const float4 &mask) { return _mm_movemask_ps(mask.v); }
+
+// round to nearest, valid for |a| < 2^31
+inline float4 round(const float4 &a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v)); }
+
+// 2^n for integral n in [-126, 127]
+inline float4 exp2i(const float4 &n)
+{
+    __m128i e = _mm_add_epi32(_mm_cvtps_epi32(n.v), _mm_set1_epi32(127));
+    return _mm_castsi128_ps(_mm_slli_epi32(e, 23));
+}
+
+// splits positive a into mantissa in [1, 2) and exponent
+inline float4 frexp2(const float4 &a, float4 &exponent)
+{
+    __m128i bits = _mm_castps_si128(a.v);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    exponent = _mm_cvtepi32_ps(e);
+    __m128i m = _mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000));
+    return _mm_castsi128_ps(m);
+}
+
+#else
+
+struct float4
+{
+    float f[4];
+
+    float4() {}
+    float4(float s) { f[0] = f[1] = f[2] = f[3] = s; }
+    float4(float a, float b, float c, float d) { f[0] = a; f[1] = b; f[2] = c; f[3] = d; }
+
+    static float4 load(const float *p) { return float4(p[0], p[1], p[2], p[3]); }
+    void store(float *p) const { for (int i = 0; i < 4; i++) p[i] = f[i]; }
+    float operator [] (int i) const { return f[i]; }
+
+#define SIMD_BINARY(op) \
+    float4 operator op (const float4 &b) const { float4 r; for (int i = 0; i < 4; i++) r.f[i] = f[i] op b.f[i]; return r; }
+#define SIMD_COMPARE(op) \
+    float4 operator op (const float4 &b) const { float4 r; for (int i = 0; i < 4; i++) r.f[i] = mask(f[i] op b.f[i]); return r; }
+#define SIMD_BITWISE(op) \
+    float4 operator op (const float4 &b) const { float4 r; for (int i = 0; i < 4; i++) r.f[i] = mask(bits(f[i]) op bits(b.f[i])); return r; }
+
+    SIMD_BINARY(+) SIMD_BINARY(-) SIMD_BINARY(*) SIMD_BINARY(/)
+    SIMD_COMPARE(<) SIMD_COMPARE(<=) SIMD_COMPARE(>) SIMD_COMPARE(>=) SIMD_COMPARE(==)
+    SIMD_BITWISE(&) SIMD_BITWISE(|)
+
+#undef SIMD_BINARY
+#undef SIMD_COMPARE
+#undef SIMD_BITWISE
+
+    float4 operator - () const { return float4(-f[0], -f[1], -f[2], -f[3]); }
+    float4 &operator += (const float4 &b) { return *this = *this + b; }
+    float4 &operator -= (const float4 &b) { return *this = *this - b; }
+    float4 &operator *= (const float4 &b) { return *this = *this * b; }
+
+    // lane masks are all ones or all zeros, like the SSE compares
+    static float mask(bool b) { union { unsigned int u; float f; } x; x.u = b ? 0xffffffffu : 0u; return x.f; }
+    static bool bits(float v) { union { unsigned int u; float f; } x; x.f = v; return x.u != 0; }
+};
+
+inline float4 min(const float4 &a, const float4 &b) { return float4(fminf(a.f[0], b.f[0]), fminf(a.f[1], b.f[1]), fminf(a.f[2], b.f[2]), fminf(a.f[3], b.f[3])); }
+inline float4 max(const float4 &a, const float4 &b) { return float4(fmaxf(a.f[0], b.f[0]), fmaxf(a.f[1], b.f[1]), fmaxf(a.f[2], b.f[2]), fmaxf(a.f[3], b.f[3])); }
+inline float4 sqrt(const float4 &a) { return float4(sqrtf(a.f[0]), sqrtf(a.f[1]), sqrtf(a.f[2]), sqrtf(a.f[3])); }
+inline float4 select(const float4 &mask, const float4 &a, const float4 &b)
+{
+    float4 r;
+    for (int i = 0; i < 4; i++) r.f[i] = float4::bits(mask.f[i]) ? a.f[i] : b.f[i];
+    return r;
+}
+inline int movemask(const float4 &mask)
+{
+    int m = 0;
+    for (int i = 0; i < 4; i++) if (float4::bits(mask.f[i])) m |= 1 << i;
+    return m;
+}
+inline float4 round(const float4 &a) { return float4(rintf(a.f[0]), rintf(a.f[1]), rintf(a.f[2]), rintf(a.f[3])); }
+inline float4 exp2i(const float4 &n) { return float4(ldexpf(1.f, (int)n.f[0]), ldexpf(1.f, (int)n.f[1]), ldexpf(1.f, (int)n.f[2]), ldexpf(1.f, (int)n.f[3])); }
+inline float4 frexp2(const float4 &a, float4 &exponent)
+{
+    float4 m;
+    for (int i = 0; i < 4; i++) {
+        int e;
+        m.f[i] = frexpf(a.f[i], &e) * 2.f;
+        exponent.f[i] = (float)(e - 1);
+    }
+    return m;
+}
+
+#endif
+
+inline bool any(const float4 &mask) { return movemask(mask) != 0; }
+inline bool all(const float4 &mask) { return movemask(mask) == 0xf; }
+inline float4 clamp(const float4 &a, const float4 &lo, const float4 &hi) { return min(max(a, lo), hi); }
+inline float4 floor(const float4 &a)
+{
+    float4 r = round(a);
+    return select(r > a, r - float4(1.f), r);
+}
+
+// sin and cos of x, accurate to a few ulp for |x| up to a few thousand
+inline void sincos(const float4 &x, float4 &s, float4 &c)
+{
+    // reduce to r in [-pi/4, pi/4] and the quadrant q, x = q * pi/2 + r
+    float4 q = round(x * float4(0.63661977236758134f));
+    float4 r = x - q * float4(1.5703125f);
+    r = r - q * float4(4.8375129699707031e-4f);
+    r = r - q * float4(7.5497899548918821e-8f);
+    q = q - float4(4.f) * floor(q * float4(0.25f));
+
+    float4 r2 = r * r;
+    float4 sr = ((float4(-1.9515295891e-4f) * r2 + float4(8.3321608736e-3f)) * r2
+                 + float4(-1.6666654611e-1f)) * r2 * r + r;
+    float4 cr = ((float4(2.443315711809948e-5f) * r2 + float4(-1.388731625493765e-3f)) * r2
+                 + float4(4.166664568298827e-2f)) * r2 * r2 - float4(0.5f) * r2 + float4(1.f);
+
+    float4 swap = (q == float4(1.f)) | (q == float4(3.f));
+    float4 sv = select(swap, cr, sr);
+    float4 cv = select(swap, sr, cr);
+    s = select(q >= float4(2.f), -sv, sv);
+    c = select((q == float4(1.f)) | (q == float4(2.f)), -cv, cv);
+}
+
+// log2 of a > 0
+inline float4 log2(const float4 &a)
+{
+    // mantissa m in [sqrt(1/2), sqrt(2)), log2(m) = 2/ln2 * atanh((m - 1)/(m + 1))
+    float4 n;
+    float4 m = frexp2(a, n);
+    float4 big = m > float4(1.41421356f);
+    m = select(big, m * float4(0.5f), m);
+    n = select(big, n + float4(1.f), n);
+    float4 t = (m - float4(1.f)) / (m + float4(1.f));
+    float4 t2 = t * t;
+    float4 lg = (((float4(2.f/9.f) * t2 + float4(2.f/7.f)) * t2 + float4(2.f/5.f)) * t2 + float4(2.f/3.f)) * t2 * t
+                + float4(2.f) * t;
+    return lg * float4(1.44269504f) + n;
+}
+
+// 2^a, clamped to the normal float range
+inline float4 exp2(const float4 &a)
+{
+    // a = k + f with f in [-1/2, 1/2]
+    float4 y = clamp(a, float4(-126.f), float4(126.f));
+    float4 k = round(y);
+    float4 f = (y - k) * float4(0.69314718f);
+    float4 ef = ((((((float4(1.f/5040.f) * f + float4(1.f/720.f)) * f + float4(1.f/120.f)) * f
+                 + float4(1.f/24.f)) * f + float4(1.f/6.f)) * f + float4(0.5f)) * f + float4(1.f)) * f + float4(1.f);
+    return ef * exp2i(k);
+}
+
+// base^e for base >= 0, e a scalar > 0, matching pow() closely enough for shading
+inline float4 pow(const float4 &base, float e)
+{
+    float4 zero = base <= float4(0.f);
+    float4 p = exp2(log2(max(base, float4(1e-30f))) * float4(e));
+    return select(zero, float4(0.f), p);
+}
+
+#endif // SIMD_H
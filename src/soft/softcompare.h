@@ -0,0 +1,13 @@
+#ifndef SOFTCOMPARE_H
+#define SOFTCOMPARE_H
+
+struct Options;
+
+// Renders one frame of the --seed waves at --size with both WaterEngine
+// (offscreen) and SoftRenderer from the window's start view, prints PSNR,
+// mean and largest difference as JSON and returns 0 if the software output
+// is within tolerance of the GL one, 1 if not. Needs a QApplication for the
+// GL context, but no window.
+int runSoftwareComparison(const Options &options);
+
+#endif // SOFTCOMPARE_H
@@ -0,0 +1,545 @@
+#include "softrenderer.h"
+#include "simd.h"
+#include "camera.h"
+#include <QtConcurrentMap>
+#include <time.h>
+
+#define GW GEOMETRIC_WAVES
+#define NMW NORMALMAP_WAVES
+
+// bands of mesh rows set up in parallel; more bands than cores keeps the
+// pool busy when the camera only sees part of the mesh
+#define SETUP_BANDS 32
+
+// triangles are clipped to this multiple of the viewport so that screen
+// coordinates stay small enough for float edge functions
+#define GUARD_BAND 3.f
+
+namespace
+{
+    struct StageJob
+    {
+        typedef void result_type;
+
+        SoftRenderer *renderer;
+        void (SoftRenderer::*stage)(int);
+
+        void operator () (int &index) const { (renderer->*stage)(index); }
+    };
+
+    // clip planes as dot(plane, position) >= 0: near and the guard band
+    const float CLIP_PLANES[5][4] = {
+        {  0.f,  0.f, 1.f, 1.f },
+        { -1.f,  0.f, 0.f, GUARD_BAND },
+        {  1.f,  0.f, 0.f, GUARD_BAND },
+        {  0.f, -1.f, 0.f, GUARD_BAND },
+        {  0.f,  1.f, 0.f, GUARD_BAND }
+    };
+
+    inline float clipDistance(int plane, const float *v)
+    {
+        const float *p = CLIP_PLANES[plane];
+        return p[0] * v[0] + p[1] * v[1] + p[2] * v[2] + p[3] * v[3];
+    }
+
+    inline int outcode(const float *v)
+    {
+        int code = 0;
+        for (int i = 0; i < 5; i++) if (clipDistance(i, v) < 0.f) code |= 1 << i;
+        return code;
+    }
+
+    inline void normalize(float4 &x, float4 &y, float4 &z)
+    {
+        float4 len = sqrt(x * x + y * y + z * z);
+        x = x / len;
+        y = y / len;
+        z = z / len;
+    }
+
+    inline float4 quantize(const float4 &x)
+    {
+        return round(clamp(x, float4(0.f), float4(1.f)) * float4(255.f)) / float4(255.f);
+    }
+}
+
+SoftRenderer::SoftRenderer(int width, int height)
+{
+    // seed random
+    srand(time(0));
+
+    // initialize waves
+    m_waves.randomize();
+    m_last_time = 0.f;
+
+    m_width = m_height = 0;
+    m_tiles_x = m_tiles_y = 0;
+    m_pixels = NULL;
+
+    setGrid(GridSettings());
+    m_bands.resize(SETUP_BANDS);
+    resize(width, height);
+}
+
+SoftRenderer::~SoftRenderer()
+{
+}
+
+void SoftRenderer::setGrid(const GridSettings &grid)
+{
+    if (!grid.isValid()) return;
+    m_grid = grid;
+    m_grid_size = grid.cells() + 1;
+    m_waves.setGrid(grid);
+
+    m_normalmap.clear();
+    for (int size = grid.texsize; size > 0; size /= 2)
+        m_normalmap.push_back(std::vector<float>(size * size * 3));
+    m_vertices.resize(m_grid_size * m_grid_size);
+}
+
+void SoftRenderer::resize(int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+    m_color.resize(width * height * 4);
+    m_depth.resize(width * height);
+    for (int i = 0; i < SETUP_BANDS; i++) m_bands[i].bins.resize(m_tiles_x * m_tiles_y);
+}
+
+void SoftRenderer::parallel(void (SoftRenderer::*stage)(int), int count)
+{
+    if (m_jobs.size() != count) {
+        m_jobs.resize(count);
+        for (int i = 0; i < count; i++) m_jobs[i] = i;
+    }
+    StageJob job = { this, stage };
+    QtConcurrent::blockingMap(m_jobs, job);
+}
+
+void SoftRenderer::render(float elapsed_time, const Camera &camera)
+{
+    m_waves.update(elapsed_time - m_last_time);
+    m_last_time = elapsed_time;
+
+    m_modelview = camera.modelviewMatrix() * Matrix4::rotation(elapsed_time * 10.f, 0.f, 1.f, 0.f);
+    m_projection = camera.projectionMatrix();
+    m_footprint = 2.f / (m_projection(1, 1) * m_height);
+
+    // detaches from frames still queued in an encoder before the workers write
+    m_pixels = (unsigned char *)m_color.data();
+
+    parallel(&SoftRenderer::shadeNormalMap, 2 * m_grid.texsize - 1);
+    parallel(&SoftRenderer::shadeVertices, m_grid_size);
+    parallel(&SoftRenderer::setupBand, SETUP_BANDS);
+    parallel(&SoftRenderer::rasterizeTile, m_tiles_x * m_tiles_y);
+}
+
+// normalmap.frag for one row of texels; the jobs cover the rows of every
+// mipmap level in turn
+void SoftRenderer::shadeNormalMap(int row)
+{
+    int level = 0, size = m_grid.texsize;
+    for (; row >= size; size /= 2, level++) row -= size;
+    float texel = 2.f * (1 << level) / m_grid.texsize;
+
+    const WaveRecord *waves = m_waves.normalMap();
+    float A[NMW], omega[NMW], lod[NMW];
+    for (int i = 0; i < NMW; i++) {
+        A[i] = waves[i].wavelength * waves[i].kAmpOverLen;
+        omega[i] = 2.f * M_PI / waves[i].wavelength;
+        lod[i] = fminf(fmaxf(waves[i].wavelength / texel * 0.5f - 1.f, 0.f), 1.f);
+    }
+
+    float4 v((row + 0.5f) * texel);
+    float *out = &m_normalmap[level][row * size * 3];
+    for (int x = 0; x < size; x += 4) {
+        float4 u = float4(x + 0.5f, x + 1.5f, x + 2.5f, x + 3.5f) * float4(texel);
+        float4 nx(0.f), ny(0.f), nz(1.f);
+        for (int i = 0; i < NMW && lod[i] > 0.f; i++) {
+            const WaveRecord &w = waves[i];
+            float k = w.steepness;
+            float4 S, C;
+            sincos(float4(omega[i]) * (float4(w.dir.x) * u + float4(w.dir.y) * v) + float4(w.phase), S, C);
+            float4 val = pow(float4(0.5f) * (S + float4(1.f)), k - 1.f) * C;
+            val = float4(omega[i] * A[i] * k) * val * float4(lod[i]);
+            nx += float4(w.dir.x) * val;
+            ny += float4(w.dir.y) * val;
+        }
+        normalize(nx, ny, nz);
+
+        // stored as the RGB8 texture the GL path renders into
+        float r[4], g[4], b[4];
+        quantize(nx * float4(0.5f) + float4(0.5f)).store(r);
+        quantize(ny * float4(0.5f) + float4(0.5f)).store(g);
+        quantize(nz * float4(0.5f) + float4(0.5f)).store(b);
+        for (int l = 0; l < 4 && x + l < size; l++) {
+            out[(x + l) * 3 + 0] = r[l];
+            out[(x + l) * 3 + 1] = g[l];
+            out[(x + l) * 3 + 2] = b[l];
+        }
+    }
+}
+
+// wave.vert for one row of the mesh grid
+void SoftRenderer::shadeVertices(int row)
+{
+    const WaveRecord *waves = m_waves.geometric();
+    float A[GW], omega[GW], Qi[GW];
+    for (int i = 0; i < GW; i++) {
+        A[i] = waves[i].wavelength * waves[i].kAmpOverLen;
+        omega[i] = 2.f * M_PI / waves[i].wavelength;
+        Qi[i] = waves[i].steepness / (omega[i] * A[i] * 4.f);
+    }
+    const float *mv = m_modelview.m, *pr = m_projection.m;
+
+    float4 z(-m_grid.extent/2.f + row * m_grid.spacing);
+    Vertex *out = &m_vertices[row * m_grid_size];
+    for (int j = 0; j < m_grid_size; j += 4) {
+        float4 x = float4(j, j + 1, j + 2, j + 3) * float4(m_grid.spacing) + float4(-m_grid.extent/2.f);
+
+        // per wave LOD from the pixel size at the undisplaced vertex's depth
+        float4 depth = -(float4(mv[2]) * x + float4(mv[10]) * z + float4(mv[14]));
+        float4 pixel = float4(m_footprint) * max(depth, float4(0.001f));
+        float4 lod[GW];
+        int count = 0;
+        for (; count < GW; count++) {
+            lod[count] = clamp(float4(waves[count].wavelength) / pixel * float4(0.5f) - float4(1.f),
+                               float4(0.f), float4(1.f));
+            if (!any(lod[count] > float4(0.f))) break;
+        }
+
+        float4 Px = x, Py(0.f), Pz = z;
+        for (int i = 0; i < count; i++) {
+            float dx = waves[i].dir.x, dz = waves[i].dir.y;
+            float4 S, C;
+            sincos(float4(omega[i]) * (float4(dx) * x + float4(dz) * z) + float4(waves[i].phase), S, C);
+            Px += lod[i] * (float4(Qi[i] * A[i] * dx) * C);
+            Py += lod[i] * (float4(A[i]) * S);
+            Pz += lod[i] * (float4(Qi[i] * A[i] * dz) * C);
+        }
+
+        float4 Bx(0.f), By(0.f), Bz(0.f), Tx(0.f), Ty(0.f), Tz(0.f), Nx(0.f), Ny(0.f), Nz(0.f);
+        for (int i = 0; i < count; i++) {
+            float dx = waves[i].dir.x, dz = waves[i].dir.y;
+            float4 WA = float4(omega[i] * A[i]) * lod[i];
+            float4 S, C;
+            sincos(float4(omega[i]) * (float4(dx) * Px + float4(dz) * Pz) + float4(waves[i].phase), S, C);
+            C = C / float4(6.f);
+            Bx += float4(Qi[i] * dx * dx) * WA * S;
+            By += float4(Qi[i] * dx * dz) * WA * S;
+            Bz += float4(dx) * WA * C;
+            Tx += float4(Qi[i] * dx * dz) * WA * S;
+            Ty += float4(Qi[i] * dz * dz) * WA * S;
+            Tz += float4(dz) * WA * C;
+            Nx += float4(dx) * WA * C;
+            Ny += float4(dz) * WA * C;
+            Nz += float4(Qi[i]) * WA * S;
+        }
+        Bx = float4(1.f) - Bx; By = -By;
+        Tx = -Tx; Ty = float4(1.f) - Ty;
+        Nx = -Nx; Ny = -Ny; Nz = float4(1.f) - Nz;
+        normalize(Bx, By, Bz);
+        normalize(Tx, Ty, Tz);
+        normalize(Nx, Ny, Nz);
+
+        // light is (0, 100, 0)
+        float4 lx = float4(100.f) * By, ly = float4(100.f) * Ty, lz = float4(100.f) * Ny;
+        normalize(lx, ly, lz);
+
+        float4 ex = float4(mv[0]) * Px + float4(mv[4]) * Py + float4(mv[8]) * Pz + float4(mv[12]);
+        float4 ey = float4(mv[1]) * Px + float4(mv[5]) * Py + float4(mv[9]) * Pz + float4(mv[13]);
+        float4 ez = float4(mv[2]) * Px + float4(mv[6]) * Py + float4(mv[10]) * Pz + float4(mv[14]);
+        float4 vx = ex * Bx + ey * By + ez * Bz;
+        float4 vy = ex * Tx + ey * Ty + ez * Tz;
+        float4 vz = ex * Nx + ey * Ny + ez * Nz;
+        normalize(vx, vy, vz);
+
+        float4 attr[12] = {
+            float4(pr[0]) * ex + float4(pr[4]) * ey + float4(pr[8]) * ez + float4(pr[12]),
+            float4(pr[1]) * ex + float4(pr[5]) * ey + float4(pr[9]) * ez + float4(pr[13]),
+            float4(pr[2]) * ex + float4(pr[6]) * ey + float4(pr[10]) * ez + float4(pr[14]),
+            float4(pr[3]) * ex + float4(pr[7]) * ey + float4(pr[11]) * ez + float4(pr[15]),
+            Px * float4(0.5f) + float4(0.5f),
+            Pz * float4(0.5f) + float4(0.5f),
+            lx, ly, lz,
+            vx, vy, vz
+        };
+        float lanes[12][4];
+        for (int k = 0; k < 12; k++) attr[k].store(lanes[k]);
+        for (int l = 0; l < 4 && j + l < m_grid_size; l++)
+            for (int k = 0; k < 12; k++) out[j + l].v[k] = lanes[k][l];
+    }
+}
+
+void SoftRenderer::setupBand(int index)
+{
+    Band &band = m_bands[index];
+    band.triangles.clear();
+    for (size_t i = 0; i < band.bins.size(); i++) band.bins[i].clear();
+
+    int quads = m_grid_size - 1;
+    int first = index * quads / SETUP_BANDS, last = (index + 1) * quads / SETUP_BANDS;
+    for (int i = first; i < last; i++) {
+        const Vertex *row = &m_vertices[i * m_grid_size], *next = row + m_grid_size;
+        for (int j = 0; j < quads; j++) {
+            // the quad in the order of the GL vertex buffer, split like GL_QUADS
+            setupTriangle(band, row[j], next[j], next[j + 1]);
+            setupTriangle(band, row[j], next[j + 1], row[j + 1]);
+        }
+    }
+}
+
+void SoftRenderer::setupTriangle(Band &band, const Vertex &a, const Vertex &b, const Vertex &c)
+{
+    int ca = outcode(a.v), cb = outcode(b.v), cc = outcode(c.v);
+    if (ca & cb & cc) return;
+    if (!(ca | cb | cc)) {
+        const Vertex *v[3] = { &a, &b, &c };
+        emitTriangle(band, v);
+        return;
+    }
+
+    // Sutherland-Hodgman against the planes some vertex is outside of
+    Vertex buffer[2][9];
+    Vertex *in = buffer[0], *out = buffer[1];
+    in[0] = a; in[1] = b; in[2] = c;
+    int n = 3, planes = ca | cb | cc;
+    for (int p = 0; p < 5; p++) {
+        if (!(planes & (1 << p))) continue;
+        int m = 0;
+        for (int k = 0; k < n; k++) {
+            const Vertex &cur = in[k], &next = in[(k + 1) % n];
+            float dc = clipDistance(p, cur.v), dn = clipDistance(p, next.v);
+            if (dc >= 0.f) out[m++] = cur;
+            if ((dc >= 0.f) != (dn >= 0.f)) {
+                float t = dc / (dc - dn);
+                for (int i = 0; i < 12; i++) out[m].v[i] = cur.v[i] + (next.v[i] - cur.v[i]) * t;
+                m++;
+            }
+        }
+        Vertex *swap = in;
+        in = out;
+        out = swap;
+        n = m;
+        if (n < 3) return;
+    }
+
+    for (int k = 1; k + 1 < n; k++) {
+        const Vertex *v[3] = { &in[0], &in[k], &in[k + 1] };
+        emitTriangle(band, v);
+    }
+}
+
+void SoftRenderer::emitTriangle(Band &band, const Vertex *v[3])
+{
+    float sx[3], sy[3], f[3][10];
+    for (int k = 0; k < 3; k++) {
+        float iw = 1.f / v[k]->v[3];
+        sx[k] = (v[k]->v[0] * iw * 0.5f + 0.5f) * m_width;
+        sy[k] = (v[k]->v[1] * iw * 0.5f + 0.5f) * m_height;
+        f[k][0] = v[k]->v[2] * iw * 0.5f + 0.5f;
+        f[k][1] = iw;
+        for (int i = 0; i < 8; i++) f[k][2 + i] = v[k]->v[4 + i] * iw;
+    }
+
+    // front faces are counter-clockwise in window coordinates
+    double area = ((double)sx[1] - sx[0]) * ((double)sy[2] - sy[0])
+                - ((double)sx[2] - sx[0]) * ((double)sy[1] - sy[0]);
+    if (area <= 0.0) return;
+
+    // pixels whose centers fall inside the bounding box
+    Triangle t;
+    t.x0 = qMax(0, (int)ceilf(qMin(sx[0], qMin(sx[1], sx[2])) - 0.5f));
+    t.y0 = qMax(0, (int)ceilf(qMin(sy[0], qMin(sy[1], sy[2])) - 0.5f));
+    t.x1 = qMin(m_width - 1, (int)floorf(qMax(sx[0], qMax(sx[1], sx[2])) - 0.5f));
+    t.y1 = qMin(m_height - 1, (int)floorf(qMax(sy[0], qMax(sy[1], sy[2])) - 0.5f));
+    if (t.x0 > t.x1 || t.y0 > t.y1) return;
+
+    // each edge is evaluated from its lexicographically smaller end, so the
+    // two triangles sharing it get exactly opposite values and no pixel is
+    // covered twice or missed
+    t.inclusive = 0;
+    for (int k = 0; k < 3; k++) {
+        int i = k, j = (k + 1) % 3;
+        bool swap = sx[j] < sx[i] || (sx[j] == sx[i] && sy[j] < sy[i]);
+        int p = swap ? j : i, q = swap ? i : j;
+        float s = swap ? -1.f : 1.f;
+        t.ea[k] = -(sy[q] - sy[p]) * s;
+        t.eb[k] = (sx[q] - sx[p]) * s;
+        t.ex[k] = sx[p];
+        t.ey[k] = sy[p];
+        // top-left rule
+        if (t.ea[k] > 0.f || (t.ea[k] == 0.f && t.eb[k] < 0.f)) t.inclusive |= 1 << k;
+    }
+
+    // planes of depth, 1/w and varying/w relative to the first vertex
+    float d1x = sx[1] - sx[0], d1y = sy[1] - sy[0];
+    float d2x = sx[2] - sx[0], d2y = sy[2] - sy[0];
+    float inv = 1.f / (float)area;
+    t.ox = sx[0];
+    t.oy = sy[0];
+    for (int i = 0; i < 10; i++) {
+        float df1 = f[1][i] - f[0][i], df2 = f[2][i] - f[0][i];
+        t.plane[i][0] = (df1 * d2y - df2 * d1y) * inv;
+        t.plane[i][1] = (df2 * d1x - df1 * d2x) * inv;
+        t.plane[i][2] = f[0][i];
+    }
+
+    int index = (int)band.triangles.size();
+    band.triangles.push_back(t);
+    for (int ty = t.y0 / TILE_SIZE; ty <= t.y1 / TILE_SIZE; ty++)
+        for (int tx = t.x0 / TILE_SIZE; tx <= t.x1 / TILE_SIZE; tx++)
+            band.bins[ty * m_tiles_x + tx].push_back(index);
+}
+
+void SoftRenderer::rasterizeTile(int tile)
+{
+    int x0 = (tile % m_tiles_x) * TILE_SIZE, y0 = (tile / m_tiles_x) * TILE_SIZE;
+    int x1 = qMin(x0 + TILE_SIZE, m_width) - 1, y1 = qMin(y0 + TILE_SIZE, m_height) - 1;
+
+    // glClearColor(0.59, 0.78, 0.93, 1) and a depth of 1
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            unsigned char *c = m_pixels + (y * m_width + x) * 4;
+            c[0] = 150; c[1] = 199; c[2] = 237; c[3] = 255;
+            m_depth[y * m_width + x] = 1.f;
+        }
+    }
+
+    for (int b = 0; b < SETUP_BANDS; b++) {
+        const Band &band = m_bands[b];
+        const std::vector<int> &bin = band.bins[tile];
+        for (size_t n = 0; n < bin.size(); n++) {
+            const Triangle &t = band.triangles[bin[n]];
+            int bx0 = qMax(x0, t.x0), bx1 = qMin(x1, t.x1);
+            int by0 = qMax(y0, t.y0), by1 = qMin(y1, t.y1);
+
+            for (int y = by0; y <= by1; y++) {
+                float py = y + 0.5f;
+                float4 ey[3];
+                for (int k = 0; k < 3; k++) ey[k] = float4(t.eb[k] * (py - t.ey[k]));
+
+                for (int x = bx0 & ~3; x <= bx1; x += 4) {
+                    float4 px = float4(x + 0.5f, x + 1.5f, x + 2.5f, x + 3.5f);
+                    int mask = 0xf;
+                    for (int k = 0; k < 3; k++) {
+                        float4 e = float4(t.ea[k]) * (px - float4(t.ex[k])) + ey[k];
+                        mask &= movemask((t.inclusive & (1 << k)) ? e >= float4(0.f) : e > float4(0.f));
+                    }
+                    if (x < bx0) mask &= 0xf << (bx0 - x);
+                    if (x + 3 > bx1) mask &= 0xf >> (x + 3 - bx1);
+                    if (mask) shadePixels(t, x, y, mask, &m_depth[y * m_width + x],
+                                          m_pixels + (y * m_width + x) * 4);
+                }
+            }
+        }
+    }
+}
+
+// wave.frag for the pixels x..x+3 of row y selected by mask
+void SoftRenderer::shadePixels(const Triangle &t, int x, int y, int mask, float *depth, unsigned char *color)
+{
+    float4 dx = float4(x + 0.5f, x + 1.5f, x + 2.5f, x + 3.5f) - float4(t.ox);
+    float dy = y + 0.5f - t.oy;
+#define PLANE(i) (float4(t.plane[i][0]) * dx + float4(t.plane[i][1] * dy + t.plane[i][2]))
+
+    // depth test, GL_LESS, and the far plane
+    float stored[4];
+    for (int l = 0; l < 4; l++) stored[l] = (mask & (1 << l)) ? depth[l] : 0.f;
+    float4 z = PLANE(0);
+    mask &= movemask((z < float4::load(stored)) & (z <= float4(1.f)));
+    if (!mask) return;
+
+    float4 w = float4(1.f) / PLANE(1);
+    float4 s = PLANE(2) * w, tc = PLANE(3) * w;
+    float4 lx = PLANE(4) * w, ly = PLANE(5) * w, lz = PLANE(6) * w;
+    float4 vx = PLANE(7) * w, vy = PLANE(8) * w, vz = PLANE(9) * w;
+#undef PLANE
+
+    // texture2D(normalmap, texcoord*0.125) with GL_LINEAR_MIPMAP_LINEAR. The
+    // level comes from the exact screen derivatives of the texture coordinates.
+    float4 dsdx = (float4(t.plane[2][0]) - s * float4(t.plane[1][0])) * w;
+    float4 dsdy = (float4(t.plane[2][1]) - s * float4(t.plane[1][1])) * w;
+    float4 dtdx = (float4(t.plane[3][0]) - tc * float4(t.plane[1][0])) * w;
+    float4 dtdy = (float4(t.plane[3][1]) - tc * float4(t.plane[1][1])) * w;
+    float4 rho2 = max(dsdx * dsdx + dtdx * dtdx, dsdy * dsdy + dtdy * dtdy)
+                * float4(0.125f * m_grid.texsize * 0.125f * m_grid.texsize);
+    float4 level = clamp(log2(max(rho2, float4(1e-20f))) * float4(0.5f),
+                         float4(0.f), float4(m_normalmap.size() - 1));
+
+    float sl[4], tl[4], ll[4], texel[3][4];
+    s.store(sl);
+    tc.store(tl);
+    level.store(ll);
+    for (int l = 0; l < 4; l++) {
+        int l0 = (int)ll[l];
+        float f = ll[l] - l0;
+        float a[3], b[3];
+        sampleNormalMap(l0, sl[l], tl[l], a);
+        if (f > 0.f) {
+            sampleNormalMap(l0 + 1, sl[l], tl[l], b);
+            for (int c = 0; c < 3; c++) a[c] += (b[c] - a[c]) * f;
+        }
+        for (int c = 0; c < 3; c++) texel[c][l] = a[c];
+    }
+    float4 n[3];
+    for (int c = 0; c < 3; c++) n[c] = float4::load(texel[c]) * float4(2.f) - float4(1.f);
+    normalize(n[0], n[1], n[2]);
+
+    // specular: pow(clamp(dot(reflect(normalize(lightv), N), viewv), 0, 1), 50)
+    normalize(lx, ly, lz);
+    float4 ln = float4(2.f) * (lx * n[0] + ly * n[1] + lz * n[2]);
+    float4 rx = lx - ln * n[0], ry = ly - ln * n[1], rz = lz - ln * n[2];
+    float4 sp = clamp(rx * vx + ry * vy + rz * vz, float4(0.f), float4(1.f));
+    float4 sp2 = sp * sp, sp16 = sp2 * sp2 * sp2 * sp2;
+    sp16 = sp16 * sp16;
+    float4 specular = sp16 * sp16 * sp16 * sp2;
+
+    // fresnel with R_0 = 0.4
+    float4 vlen = sqrt(vx * vx + vy * vy + vz * vz);
+    float4 f = float4(1.f) + (vx * n[0] + vy * n[1] + vz * n[2]) / vlen;
+    float4 f5 = f * f * f * f * f;
+    float4 fresnel = clamp(float4(0.4f) + float4(0.6f) * f5, float4(0.f), float4(1.f));
+
+    // mix(oceanblue, skyblue, fresnel) + specular
+    const float ocean[3] = { 0.f, 0.f, 0.2f };
+    const float sky[3] = { 0.39f * 0.9f, 0.52f * 0.9f, 0.93f * 0.9f };
+    float rgb[3][4], z4[4];
+    for (int c = 0; c < 3; c++) {
+        float4 v = float4(ocean[c]) * (float4(1.f) - fresnel) + float4(sky[c]) * fresnel + specular;
+        (clamp(v, float4(0.f), float4(1.f)) * float4(255.f) + float4(0.5f)).store(rgb[c]);
+    }
+    z.store(z4);
+
+    for (int l = 0; l < 4; l++) {
+        if (!(mask & (1 << l))) continue;
+        depth[l] = z4[l];
+        color[l * 4 + 0] = (unsigned char)rgb[0][l];
+        color[l * 4 + 1] = (unsigned char)rgb[1][l];
+        color[l * 4 + 2] = (unsigned char)rgb[2][l];
+        color[l * 4 + 3] = 255;
+    }
+}
+
+// GL_LINEAR with GL_REPEAT in one mipmap level
+void SoftRenderer::sampleNormalMap(int level, float s, float t, float *rgb) const
+{
+    int size = m_grid.texsize >> level;
+    const float *texels = &m_normalmap[level][0];
+    float fu = s * 0.125f * size - 0.5f, fv = t * 0.125f * size - 0.5f;
+    float iu = floorf(fu), iv = floorf(fv);
+    float au = fu - iu, av = fv - iv;
+    int u0 = (int)iu & (size - 1), u1 = (u0 + 1) & (size - 1);
+    int v0 = (int)iv & (size - 1), v1 = (v0 + 1) & (size - 1);
+    const float *c00 = texels + (v0 * size + u0) * 3, *c10 = texels + (v0 * size + u1) * 3;
+    const float *c01 = texels + (v1 * size + u0) * 3, *c11 = texels + (v1 * size + u1) * 3;
+    for (int c = 0; c < 3; c++) {
+        float bottom = c00[c] + (c10[c] - c00[c]) * au;
+        float top = c01[c] + (c11[c] - c01[c]) * au;
+        rgb[c] = bottom + (top - bottom) * av;
+    }
+}
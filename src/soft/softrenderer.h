@@ -0,0 +1,116 @@
+#ifndef SOFTRENDERER_H
+#define SOFTRENDERER_H
+
+#include <QByteArray>
+#include <QVector>
+#include <vector>
+
+#include "matrix.h"
+#include "waveset.h"
+
+class Camera;
+
+// Edge length in pixels of the square screen tiles triangles are binned into
+#define TILE_SIZE 64
+
+// CPU implementation of WaterEngine for machines without a GPU. Renders the
+// same surface with ports of normalmap.frag, wave.vert and wave.frag that
+// evaluate four texels, vertices or pixels at a time (see simd.h), and
+// spreads each stage over the global QThreadPool:
+//
+//   - the normal map mipmap levels by texel rows
+//   - the vertex shader by rows of the shared mesh grid
+//   - clipping, culling and triangle setup by bands of quads, each binning
+//     its triangles into the screen tiles they touch
+//   - rasterization and shading by tile, with a depth test, walking the
+//     bands in order so the result matches drawing the mesh front to back
+//
+// The frame is RGBA in the bottom-up row order of glReadPixels, so it can be
+// handed to FrameEncoder unchanged.
+class SoftRenderer
+{
+public:
+    SoftRenderer(int width, int height);
+    ~SoftRenderer();
+
+    void resize(int width, int height);
+    inline int width() const { return m_width; }
+    inline int height() const { return m_height; }
+
+    inline const WaveParameters &parameters() const { return m_waves.parameters(); }
+    inline void setParameters(const WaveParameters &params) { m_waves.setParameters(params); }
+    inline void setBlendTime(float seconds) { m_waves.setBlendTime(seconds); }
+    inline void randomizeWaves(unsigned int seed) { srand(seed); m_waves.randomize(); }
+
+    // mesh and normal map resolution, applied right away; waves randomized
+    // afterwards are picked for it
+    inline const GridSettings &grid() const { return m_grid; }
+    void setGrid(const GridSettings &grid);
+
+    // same as clearing and calling WaterEngine::render() with the camera's
+    // matrices loaded
+    void render(float elapsed_time, const Camera &camera);
+
+    inline const QByteArray &pixels() const { return m_color; }
+
+    // packed geometric wave records, see wavefunction.h
+    inline const float *geometricWaves() const { return (const float *)m_waves.geometric(); }
+
+private:
+    // clip space position followed by texcoord, lightv and viewv
+    struct Vertex
+    {
+        float v[12];
+    };
+
+    // screen space setup of one triangle: edge functions relative to the
+    // edge's first vertex and planes of depth, 1/w and the varyings over w
+    struct Triangle
+    {
+        float ea[3], eb[3], ex[3], ey[3];
+        int inclusive; // bit i: pixels centered on edge i are covered
+        int x0, y0, x1, y1;
+        float ox, oy;
+        float plane[10][3];
+    };
+
+    struct Band
+    {
+        std::vector<Triangle> triangles;
+        std::vector< std::vector<int> > bins; // triangle indices per tile
+    };
+
+    void parallel(void (SoftRenderer::*stage)(int), int count);
+
+    void shadeNormalMap(int row);
+    void shadeVertices(int row);
+    void setupBand(int band);
+    void rasterizeTile(int tile);
+
+    void setupTriangle(Band &band, const Vertex &a, const Vertex &b, const Vertex &c);
+    void emitTriangle(Band &band, const Vertex *v[3]);
+    void shadePixels(const Triangle &t, int x, int y, int mask, float *depth, unsigned char *color);
+    void sampleNormalMap(int level, float s, float t, float *rgb) const;
+
+    WaveSet m_waves;
+    float m_last_time;
+
+    int m_width, m_height, m_tiles_x, m_tiles_y;
+    QByteArray m_color;
+    std::vector<float> m_depth;
+    unsigned char *m_pixels;
+
+    // mipmap levels of rgb texels, 8-bit quantized like the GL texture
+    std::vector< std::vector<float> > m_normalmap;
+    std::vector<Vertex> m_vertices;
+    std::vector<Band> m_bands;
+    QVector<int> m_jobs;
+
+    GridSettings m_grid;
+    int m_grid_size; // vertices along each side of the mesh grid
+
+    Matrix4 m_modelview, m_projection;
+    float m_footprint;
+};
+
+#endif // SOFTRENDERER_H
@@ -0,0 +1,114 @@
+#include "softrunner.h"
+#include "softrenderer.h"
+#include "options.h"
+#include "camera.h"
+#include "benchmark.h"
+#include "frameencoder.h"
+#include "heightfieldwriter.h"
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <iostream>
+#include <time.h>
+
+#define FRAMES_PER_SECOND 60
+
+int runSoftwareRenderer(const Options &options)
+{
+    Benchmark bench;
+    bool benchmark = !options.benchmark_path.isEmpty();
+    if (benchmark) {
+        if (!bench.load(options.benchmark_path)) return 2;
+        bench.setCpuOnly("software");
+    }
+
+    int width = benchmark ? bench.width() : options.width;
+    int height = benchmark ? bench.height() : options.height;
+    if (width <= 0 || height <= 0 || options.frames <= 0) {
+        std::cout << "error: Invalid frame size or count" << std::endl;
+        return 2;
+    }
+    if (options.threads > 0) QThreadPool::globalInstance()->setMaxThreadCount(options.threads);
+
+    // same view as the window starts with
+    Camera camera(45.f, (float)width/(float)height, 0.1f, 1000.f);
+    camera.setZoom(60.f);
+    camera.setAngles(0.f, M_PI_4*0.5f);
+
+    // main() has validated it
+    GridSettings grid = options.grid();
+
+    SoftRenderer renderer(width, height);
+    renderer.setGrid(grid);
+    renderer.setBlendTime(0.f);
+    if (benchmark) {
+        if (bench.hasParameters()) renderer.setParameters(bench.parameters());
+        renderer.randomizeWaves(bench.seed());
+    } else {
+        // waves for the grid in use
+        renderer.randomizeWaves(options.has_seed ? options.seed : time(0));
+    }
+
+    FrameEncoder *encoder = NULL;
+    if (options.capture_on_start) {
+        encoder = new FrameEncoder();
+        if (encoder->open(options.capture_path, width, height, FRAMES_PER_SECOND)) {
+            std::cout << "Recording to " << qPrintable(options.capture_path) << std::endl;
+        } else {
+            delete encoder;
+            encoder = NULL;
+        }
+    }
+
+    HeightFieldWriter *heights = NULL;
+    if (!options.heights_path.isEmpty()) {
+        HeightFieldRegion region;
+        region.x0 = options.heights_region[0];
+        region.z0 = options.heights_region[1];
+        region.x1 = options.heights_region[2];
+        region.z1 = options.heights_region[3];
+        region.nx = options.heights_nx;
+        region.nz = options.heights_nz;
+        heights = new HeightFieldWriter();
+        if (!heights->open(options.heights_path, region, 1.f/FRAMES_PER_SECOND)) {
+            delete heights;
+            heights = NULL;
+        }
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    int frames = 0;
+    for (;;) {
+        float elapsed;
+        if (benchmark) {
+            if (bench.isDone()) break;
+            elapsed = bench.time();
+            bench.beginFrame(&camera);
+        } else {
+            if (frames >= options.frames) break;
+            elapsed = (float)frames / FRAMES_PER_SECOND;
+        }
+
+        renderer.render(elapsed, camera);
+
+        if (benchmark) bench.endFrame();
+        if (encoder) encoder->push(renderer.pixels());
+        if (heights) heights->push(elapsed, renderer.geometricWaves(), GEOMETRIC_WAVES);
+        frames++;
+    }
+    qint64 ms = timer.elapsed();
+
+    if (encoder) {
+        encoder->finish();
+        std::cout << "Recorded " << frames << " frames" << std::endl;
+        delete encoder;
+    }
+    delete heights;
+
+    if (benchmark) return bench.finish(options.benchmark_report);
+
+    std::cout << "Rendered " << frames << " frames of " << width << "x" << height << " in "
+              << ms << " ms (" << (double)ms / frames << " ms/frame, "
+              << QThreadPool::globalInstance()->maxThreadCount() << " threads)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,11 @@
+#ifndef SOFTRUNNER_H
+#define SOFTRUNNER_H
+
+struct Options;
+
+// Renders options.frames frames (or the --benchmark run) with SoftRenderer,
+// feeding --capture and --heights like the window does, and returns the
+// process exit code. Needs no display and no GL context.
+int runSoftwareRenderer(const Options &options);
+
+#endif // SOFTRUNNER_H
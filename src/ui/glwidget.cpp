@@ -1,8 +1,16 @@
 #include "glwidget.h"
 #include "camera.h"
 #include "waterengine.h"
+#include "framecapture.h"
+#include "heightfieldwriter.h"
+#include "benchmark.h"
+#include "glresources.h"
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <iostream>
 
-GLWidget::GLWidget(QWidget *parent) : QGLWidget(parent)
+GLWidget::GLWidget(const Options &options, QWidget *parent, GLWidget *share)
+    : QGLWidget(parent, share), m_options(options)
 {
     setFocusPolicy(Qt::StrongFocus);
     connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
@@ -11,43 +19,189 @@ GLWidget::GLWidget(QWidget *parent) : QGLWidget(parent)
     m_camera->setZoom(60.f);
     m_camera->setAngles(0.f, M_PI_4*0.5f);
     m_engine = NULL;
+    m_share = share;
+    // until the next frame, show the moment the shared waves are at
+    m_elapsed = share ? share->m_elapsed : 0.f;
+    m_params = WaveSet::defaultParameters();
+    m_grid = options.grid();
+    m_blend_time = 1.f;
+    m_capture = new FrameCapture();
+    m_heights = NULL;
+    m_bench = NULL;
+
+    if (!options.heights_path.isEmpty()) {
+        HeightFieldRegion region;
+        region.x0 = options.heights_region[0];
+        region.z0 = options.heights_region[1];
+        region.x1 = options.heights_region[2];
+        region.z1 = options.heights_region[3];
+        region.nx = options.heights_nx;
+        region.nz = options.heights_nz;
+        m_heights = new HeightFieldWriter();
+        if (!m_heights->open(options.heights_path, region, 1.f/FRAMES_PER_SECOND)) {
+            delete m_heights;
+            m_heights = NULL;
+        }
+    }
 }
 
 GLWidget::~GLWidget()
 {
+    if (!m_options.record_camera_path.isEmpty() && !m_recording.save(m_options.record_camera_path))
+        std::cout << "error: Cannot write " << qPrintable(m_options.record_camera_path) << std::endl;
+
+    delete m_heights;
+    makeCurrent();
+    if (m_bench) m_bench->releaseGpu();
+    delete m_capture;
     delete m_camera;
     delete m_engine;
 }
 
 void GLWidget::initializeGL()
 {
-    m_engine = new WaterEngine();
+    // a view sharing its context renders the same waves with the same
+    // resources, which are already set up
+    WaterEngine *share = NULL;
+    if (m_share && m_share->m_engine) {
+        if (isSharing()) share = m_share->m_engine;
+        else std::cout << "warning: Cannot share GL objects with the first view" << std::endl;
+    }
+    m_share = NULL;
+
+    m_engine = new WaterEngine(m_options.shader_dir, m_grid, share);
+    if (!m_engine->isValid()) {
+        // a benchmark of nothing would pass, so it fails instead
+        std::cout << "error: Cannot set up the renderer" << std::endl;
+        if (m_bench) QCoreApplication::exit(2);
+        return;
+    }
+    if (!share) {
+        m_engine->setBlendTime(m_blend_time);
+        m_engine->setParameters(m_params);
+    }
 
-    m_time.start();
-    m_timer.start(1000/60);
+    if (m_bench) {
+        // same waves on every run; frames are rendered as fast as possible
+        m_engine->setBlendTime(0.f);
+        if (m_bench->hasParameters()) m_engine->setParameters(m_bench->parameters());
+        m_engine->randomizeWaves(m_bench->seed());
+        m_timer.start(0);
+    }
+    // otherwise the owner calls showFrame() for every frame
+}
+
+void GLWidget::setBenchmark(Benchmark *bench)
+{
+    m_bench = bench;
 }
 
-static float elapsed = 0.f;
 void GLWidget::paintGL()
 {
+    // measuring starts once the mesh is in place
+    bool measure = m_bench && !m_bench->isDone() && !m_engine->gridPending();
+    if (measure) {
+        m_elapsed = m_bench->time();
+        m_bench->beginFrame(m_camera);
+    }
+
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     m_camera->loadModelviewMatrix();
 
-    m_engine->render(elapsed);
+    m_engine->render(m_elapsed);
+
+    if (measure) {
+        m_bench->endFrame();
+        if (m_bench->isDone()) {
+            m_timer.stop();
+            QCoreApplication::exit(m_bench->finish(m_options.benchmark_report));
+        }
+    }
+
+    // recording starts with the first frame, once the final size is known
+    if (m_options.capture_on_start) {
+        m_options.capture_on_start = false;
+        startCapture();
+    }
+    if (m_capture->isActive()) m_capture->capture();
 }
 
 void GLWidget::resizeGL(int w, int h)
 {
     glViewport(0, 0, w, h);
     m_camera->setAspect((float)w/(float)h);
+
+    // the stream has a fixed frame size
+    if (m_capture->isActive() && (w != m_capture->width() || h != m_capture->height())) {
+        std::cout << "warning: Window resized, capture stopped" << std::endl;
+        m_capture->stop();
+    }
 }
 
-void GLWidget::tick()
+void GLWidget::startCapture()
+{
+    makeCurrent();
+    if (m_capture->start(m_options.capture_path, width(), height(), FRAMES_PER_SECOND))
+        std::cout << "Recording to " << qPrintable(m_options.capture_path) << std::endl;
+}
+
+void GLWidget::stopCapture()
+{
+    if (!m_capture->isActive()) return;
+    makeCurrent();
+    m_capture->stop();
+    std::cout << "Recorded " << m_capture->frameCount() << " frames" << std::endl;
+}
+
+void GLWidget::setWaveParameters(const WaveParameters &params)
+{
+    m_params = params;
+    if (m_engine) m_engine->setParameters(params);
+}
+
+void GLWidget::setGrid(const GridSettings &grid)
+{
+    m_grid = grid;
+    if (m_engine) m_engine->setGrid(grid);
+}
+
+void GLWidget::setBlendTime(double seconds)
+{
+    m_blend_time = seconds;
+    if (m_engine) m_engine->setBlendTime(seconds);
+}
+
+void GLWidget::randomizeWaves()
+{
+    if (m_engine) m_engine->randomizeWaves();
+}
+
+void GLWidget::showFrame(float elapsed)
 {
-    float seconds = m_time.restart() * 0.001f;
-    elapsed += seconds;
+    m_elapsed = elapsed;
+    if (!m_options.record_camera_path.isEmpty()) m_recording.record(elapsed, m_camera);
+    tick();
+}
 
+void GLWidget::tick()
+{
+    // benchmarks advance simulated time per frame in paintGL
     updateGL();
+
+    // updateGL() has rendered, so the waves have been advanced to m_elapsed
+    if (m_heights && m_engine) m_heights->push(m_elapsed, m_engine->geometricWaves(), GEOMETRIC_WAVES);
+}
+
+void GLWidget::keyPressEvent(QKeyEvent *event)
+{
+    if (event->key() == Qt::Key_F9) {
+        if (m_capture->isActive()) stopCapture();
+        else startCapture();
+    } else if (event->key() == Qt::Key_F10) {
+        std::cout << QJsonDocument(GLResources::report()).toJson().constData() << std::flush;
+    } else {
+        QGLWidget::keyPressEvent(event);
+    }
 }
 
 void GLWidget::mousePressEvent(QMouseEvent *event)
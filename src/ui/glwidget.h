@@ -2,40 +2,75 @@
 #define GLWIDGET_H
 
 #include <QGLWidget>
-#include <QTime>
 #include <QTimer>
+#include <QKeyEvent>
 #include <QMouseEvent>
 #include <QWheelEvent>
 #include "vector.h"
+#include "options.h"
+#include "waveset.h"
+#include "camerapath.h"
 
 class Camera;
 class WaterEngine;
+class FrameCapture;
+class HeightFieldWriter;
+class Benchmark;
+
+#define FRAMES_PER_SECOND 60
 
 class GLWidget : public QGLWidget
 {
 Q_OBJECT
 public:
-    GLWidget(QWidget *parent = 0);
+    // share: a view whose waves and GL resources this one renders too
+    GLWidget(const Options &options, QWidget *parent = 0, GLWidget *share = 0);
     ~GLWidget();
 
+    void startCapture();
+    void stopCapture();
+
+    // drive the view from a benchmark instead of the wall clock and mouse
+    void setBenchmark(Benchmark *bench);
+
+    // renders the waves at elapsed seconds. Views sharing waves must all be
+    // given the same time each frame, so only the first of them advances
+    // the waves and renders the normal map.
+    void showFrame(float elapsed);
+
+public slots:
+    void setWaveParameters(const WaveParameters &params);
+    void setBlendTime(double seconds);
+    void setGrid(const GridSettings &grid);
+    void randomizeWaves();
+
 private:
     void initializeGL();
     void paintGL();
     void resizeGL(int w, int h);
 
+    void keyPressEvent(QKeyEvent *event);
     void mousePressEvent(QMouseEvent *event);
     void mouseMoveEvent(QMouseEvent *event);
     void wheelEvent(QWheelEvent *event);
 
-    QTime m_time;
-    QTimer m_timer;
+    QTimer m_timer; // benchmarks only
+    float m_elapsed;
     Vector2 m_mousep;
     Camera *m_camera;
     WaterEngine *m_engine;
+    GLWidget *m_share;
+    FrameCapture *m_capture;
+    HeightFieldWriter *m_heights;
+    Options m_options;
+    WaveParameters m_params;
+    GridSettings m_grid;
+    float m_blend_time;
+    Benchmark *m_bench;
+    CameraPath m_recording;
 
 private slots:
     void tick();
 };
 
 #endif // GLWIDGET_H
-
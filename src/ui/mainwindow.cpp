@@ -1,7 +1,60 @@
 #include "mainwindow.h"
 #include "glwidget.h"
+#include "parameterpanel.h"
+#include <QFileInfo>
+#include <QMenu>
+#include <QMenuBar>
 
-MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
+MainWindow::MainWindow(const Options &options, QWidget *parent) : QMainWindow(parent), m_options(options)
 {
-    setCentralWidget(new GLWidget(this));
+    m_view = new GLWidget(options, this);
+    setCentralWidget(m_view);
+    m_views = 1;
+
+    ParameterPanel *panel = new ParameterPanel(options.grid(), this);
+    addDockWidget(Qt::RightDockWidgetArea, panel);
+    connect(panel, SIGNAL(parametersChanged(WaveParameters)), m_view, SLOT(setWaveParameters(WaveParameters)));
+    connect(panel, SIGNAL(blendTimeChanged(double)), m_view, SLOT(setBlendTime(double)));
+    connect(panel, SIGNAL(randomizeRequested()), m_view, SLOT(randomizeWaves()));
+    connect(panel, SIGNAL(gridChanged(GridSettings)), m_view, SLOT(setGrid(GridSettings)));
+
+    QMenu *view = menuBar()->addMenu("&View");
+    view->addAction("&New window", this, SLOT(newView()), Qt::CTRL + Qt::Key_N);
+
+    connect(&m_timer, SIGNAL(timeout()), this, SLOT(tick()));
+    m_clock.start();
+    m_timer.start(1000/FRAMES_PER_SECOND);
+}
+
+void MainWindow::tick()
+{
+    // every view gets the same time, so the first advances the shared waves
+    // and renders the normal map once and the others reuse it
+    float elapsed = m_clock.elapsed() * 0.001f;
+    m_view->showFrame(elapsed);
+    for (int i = 0; i < m_windows.size(); i++) {
+        if (m_windows[i]) m_windows[i]->showFrame(elapsed);
+        else m_windows.removeAt(i--);
+    }
+}
+
+void MainWindow::newView()
+{
+    // the panel drives the shared waves through the first view. Recording
+    // and exports stay with it too, F9 records each window to its own file.
+    Options options = m_options;
+    QFileInfo capture(options.capture_path);
+    options.capture_path = capture.path() + "/" + capture.completeBaseName() + "-" + QString::number(++m_views);
+    if (!capture.suffix().isEmpty()) options.capture_path += "." + capture.suffix();
+    options.capture_on_start = false;
+    options.heights_path.clear();
+    options.record_camera_path.clear();
+
+    GLWidget *view = new GLWidget(options, this, m_view);
+    view->setWindowFlags(Qt::Window);
+    view->setAttribute(Qt::WA_DeleteOnClose);
+    view->setWindowTitle(QString("View %1").arg(m_views));
+    view->resize(m_view->size());
+    view->show();
+    m_windows.append(view);
 }
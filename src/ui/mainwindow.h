@@ -2,12 +2,35 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QList>
+#include "options.h"
+
+class GLWidget;
 
 class MainWindow : public QMainWindow
 {
 Q_OBJECT
 public:
-    explicit MainWindow(QWidget *parent = 0);
+    explicit MainWindow(const Options &options, QWidget *parent = 0);
+
+public slots:
+    // opens another window onto the same waves from its own camera
+    void newView();
+
+private slots:
+    void tick();
+
+private:
+    Options m_options;
+    GLWidget *m_view;
+    QList< QPointer<GLWidget> > m_windows; // further views, NULL once closed
+    int m_views;
+    // one timer and clock for all views
+    QTimer m_timer;
+    QElapsedTimer m_clock;
 };
 
 #endif // MAINWINDOW_H
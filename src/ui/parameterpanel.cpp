@@ -0,0 +1,89 @@
+#include "parameterpanel.h"
+#include <QComboBox>
+#include <QDoubleSpinBox>
+#include <QFormLayout>
+#include <QPushButton>
+#include <math.h>
+
+// enough decimals to show value unrounded, so a widget never alters it
+static int decimalsFor(double value, int decimals)
+{
+    while (decimals < 6) {
+        double scaled = value * pow(10.0, decimals);
+        if (fabs(scaled - floor(scaled + 0.5)) < 1e-3) break;
+        decimals++;
+    }
+    return decimals;
+}
+
+ParameterPanel::ParameterPanel(const GridSettings &grid, QWidget *parent) : QDockWidget("Waves", parent)
+{
+    m_params = WaveSet::defaultParameters();
+
+    QWidget *contents = new QWidget(this);
+    QFormLayout *form = new QFormLayout(contents);
+
+    m_wavelength = addSpinBox(form, "Wavelength", 1.0, 50.0, 0.5, 1, m_params.wavelength);
+    m_steepness = addSpinBox(form, "Steepness", 0.0, 1.0, 0.05, 2, m_params.steepness);
+    m_speed = addSpinBox(form, "Speed", 0.0, 1.0, 0.01, 2, m_params.speed);
+    m_amplitude = addSpinBox(form, "Amplitude", 0.0, 0.1, 0.002, 3, m_params.kAmpOverLen);
+    m_amplitude->setToolTip("Amplitude as a fraction of the wavelength");
+    connect(m_wavelength, SIGNAL(valueChanged(double)), this, SLOT(valueChanged()));
+    connect(m_steepness, SIGNAL(valueChanged(double)), this, SLOT(valueChanged()));
+    connect(m_speed, SIGNAL(valueChanged(double)), this, SLOT(valueChanged()));
+    connect(m_amplitude, SIGNAL(valueChanged(double)), this, SLOT(valueChanged()));
+
+    QDoubleSpinBox *blend = addSpinBox(form, "Blend time", 0.0, 10.0, 0.1, 1, 1.0);
+    blend->setSuffix(" s");
+    connect(blend, SIGNAL(valueChanged(double)), this, SIGNAL(blendTimeChanged(double)));
+
+    QPushButton *randomize = new QPushButton("Randomize", contents);
+    connect(randomize, SIGNAL(clicked()), this, SIGNAL(randomizeRequested()));
+    form->addRow(randomize);
+
+    // the ranges always include the valid settings the view started with
+    double min_spacing = qMin(0.1, (double)grid.spacing), max_spacing = qMax(10.0, (double)grid.spacing);
+    m_extent = addSpinBox(form, "Mesh size", qMin(10.0, (double)grid.extent), MAX_GRID_CELLS * max_spacing,
+                          10.0, decimalsFor(grid.extent, 0), grid.extent);
+    m_spacing = addSpinBox(form, "Mesh spacing", min_spacing, max_spacing,
+                           0.1, decimalsFor(grid.spacing, 2), grid.spacing);
+    m_texsize = new QComboBox();
+    for (int size = MIN_TEXSIZE; size <= MAX_TEXSIZE; size *= 2) m_texsize->addItem(QString::number(size), size);
+    m_texsize->setCurrentIndex(m_texsize->findData(grid.texsize));
+    form->addRow("Normal map", m_texsize);
+    connect(m_extent, SIGNAL(valueChanged(double)), this, SLOT(gridValueChanged()));
+    connect(m_spacing, SIGNAL(valueChanged(double)), this, SLOT(gridValueChanged()));
+    connect(m_texsize, SIGNAL(currentIndexChanged(int)), this, SLOT(gridValueChanged()));
+
+    setWidget(contents);
+}
+
+QDoubleSpinBox *ParameterPanel::addSpinBox(QFormLayout *form, const QString &label,
+                                           double lo, double hi, double step, int decimals, double value)
+{
+    QDoubleSpinBox *box = new QDoubleSpinBox();
+    box->setRange(lo, hi);
+    box->setSingleStep(step);
+    box->setDecimals(decimals);
+    box->setValue(value);
+    form->addRow(label, box);
+    return box;
+}
+
+void ParameterPanel::valueChanged()
+{
+    m_params.wavelength = m_wavelength->value();
+    m_params.steepness = m_steepness->value();
+    m_params.speed = m_speed->value();
+    m_params.kAmpOverLen = m_amplitude->value();
+    emit parametersChanged(m_params);
+}
+
+void ParameterPanel::gridValueChanged()
+{
+    GridSettings grid;
+    grid.extent = m_extent->value();
+    grid.spacing = m_spacing->value();
+    grid.texsize = m_texsize->currentData().toInt();
+    if (grid.isValid()) emit gridChanged(grid);
+}
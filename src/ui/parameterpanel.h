@@ -0,0 +1,39 @@
+#ifndef PARAMETERPANEL_H
+#define PARAMETERPANEL_H
+
+#include <QDockWidget>
+#include "waveset.h"
+
+class QDoubleSpinBox;
+class QComboBox;
+
+// Dock with live controls for the geometric wave parameters and the grid
+// resolution. Every edit is sent straight away; the engine blends towards new
+// parameters instead of re-randomizing and switches grids in the background.
+class ParameterPanel : public QDockWidget
+{
+Q_OBJECT
+public:
+    explicit ParameterPanel(const GridSettings &grid, QWidget *parent = 0);
+
+signals:
+    void parametersChanged(const WaveParameters &params);
+    void blendTimeChanged(double seconds);
+    void randomizeRequested();
+    void gridChanged(const GridSettings &grid);
+
+private slots:
+    void valueChanged();
+    void gridValueChanged();
+
+private:
+    QDoubleSpinBox *addSpinBox(class QFormLayout *form, const QString &label,
+                               double lo, double hi, double step, int decimals, double value);
+
+    WaveParameters m_params;
+    QDoubleSpinBox *m_wavelength, *m_steepness, *m_speed, *m_amplitude;
+    QDoubleSpinBox *m_extent, *m_spacing;
+    QComboBox *m_texsize;
+};
+
+#endif // PARAMETERPANEL_H
@@ -74,6 +74,21 @@ void Camera::setProjectionMode(bool ortho)
     (this->*m_projfunc)();
 }
 
+Matrix4 Camera::projectionMatrix() const
+{
+    if (m_projfunc == &Camera::loadOrthographic)
+        return Matrix4::orthographic(-m_aspect, m_aspect, -1.f, 1.f, -1.f, 1.f);
+    return Matrix4::perspective(m_fovy, m_aspect, m_near, m_far);
+}
+
+Matrix4 Camera::modelviewMatrix() const
+{
+    return Matrix4::translation(0.f, 0.f, -m_zoom)
+         * Matrix4::rotation(m_vangle * 180.f/M_PI, 1.f, 0.f, 0.f)
+         * Matrix4::rotation(m_hangle * 180.f/M_PI, 0.f, 1.f, 0.f)
+         * Matrix4::translation(-m_translate.x, -m_translate.y, -m_translate.z);
+}
+
 void Camera::move(const Vector3 &v)
 {
     m_translate += v;
@@ -2,6 +2,7 @@
 #define CAMERA_H
 
 #include "vector.h"
+#include "matrix.h"
 
 class Camera
 {
@@ -21,6 +22,10 @@ public:
 
     void setProjectionMode(bool ortho);
 
+    // CPU copies of what the load*/multiply* functions put on the matrix stack
+    Matrix4 projectionMatrix() const;
+    Matrix4 modelviewMatrix() const;
+
     inline float zoomValue() const { return m_zoom; }
     inline const Vector3 &look() const { return m_look; }
     inline const Vector3 &center() const { return m_translate; }
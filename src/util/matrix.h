@@ -0,0 +1,95 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+#include "vector.h"
+
+// Column-major 4x4 matrix with the same layout and conventions as the fixed
+// function matrix stack, so it can stand in for glTranslatef/glRotatef/
+// gluPerspective where there is no GL context:
+//
+//     Matrix4 m = Matrix4::translation(0.f, 0.f, -5.f) * Matrix4::rotation(45.f, 0.f, 1.f, 0.f);
+//     glLoadMatrixf(m.m);
+//
+class Matrix4
+{
+public:
+    float m[16];
+
+    Matrix4() { for (int i = 0; i < 16; i++) m[i] = (i % 5 == 0) ? 1.f : 0.f; }
+
+    float &operator () (int row, int col) { return m[col * 4 + row]; }
+    float operator () (int row, int col) const { return m[col * 4 + row]; }
+
+    Matrix4 operator * (const Matrix4 &b) const
+    {
+        Matrix4 r;
+        for (int col = 0; col < 4; col++) {
+            for (int row = 0; row < 4; row++) {
+                float s = 0.f;
+                for (int k = 0; k < 4; k++) s += (*this)(row, k) * b(k, col);
+                r(row, col) = s;
+            }
+        }
+        return r;
+    }
+
+    Vector4 operator * (const Vector4 &v) const
+    {
+        return Vector4(m[0] * v.x + m[4] * v.y + m[8] * v.z + m[12] * v.w,
+                       m[1] * v.x + m[5] * v.y + m[9] * v.z + m[13] * v.w,
+                       m[2] * v.x + m[6] * v.y + m[10] * v.z + m[14] * v.w,
+                       m[3] * v.x + m[7] * v.y + m[11] * v.z + m[15] * v.w);
+    }
+
+    // Same as glTranslatef
+    static Matrix4 translation(float x, float y, float z)
+    {
+        Matrix4 r;
+        r(0, 3) = x;
+        r(1, 3) = y;
+        r(2, 3) = z;
+        return r;
+    }
+
+    // Same as glRotatef, angle in degrees around (x, y, z)
+    static Matrix4 rotation(float degrees, float x, float y, float z)
+    {
+        Vector3 a = Vector3(x, y, z).unit();
+        float rad = degrees * M_PI / 180.f;
+        float c = cosf(rad), s = sinf(rad), t = 1.f - c;
+        Matrix4 r;
+        r(0, 0) = a.x * a.x * t + c;       r(0, 1) = a.x * a.y * t - a.z * s; r(0, 2) = a.x * a.z * t + a.y * s;
+        r(1, 0) = a.y * a.x * t + a.z * s; r(1, 1) = a.y * a.y * t + c;       r(1, 2) = a.y * a.z * t - a.x * s;
+        r(2, 0) = a.x * a.z * t - a.y * s; r(2, 1) = a.y * a.z * t + a.x * s; r(2, 2) = a.z * a.z * t + c;
+        return r;
+    }
+
+    // Same as gluPerspective
+    static Matrix4 perspective(float fovy, float aspect, float near, float far)
+    {
+        float f = 1.f / tanf(fovy * M_PI / 360.f);
+        Matrix4 r;
+        r(0, 0) = f / aspect;
+        r(1, 1) = f;
+        r(2, 2) = (far + near) / (near - far);
+        r(2, 3) = 2.f * far * near / (near - far);
+        r(3, 2) = -1.f;
+        r(3, 3) = 0.f;
+        return r;
+    }
+
+    // Same as glOrtho
+    static Matrix4 orthographic(float left, float right, float bottom, float top, float near, float far)
+    {
+        Matrix4 r;
+        r(0, 0) = 2.f / (right - left);
+        r(1, 1) = 2.f / (top - bottom);
+        r(2, 2) = -2.f / (far - near);
+        r(0, 3) = -(right + left) / (right - left);
+        r(1, 3) = -(top + bottom) / (top - bottom);
+        r(2, 3) = -(far + near) / (far - near);
+        return r;
+    }
+};
+
+#endif // MATRIX_H
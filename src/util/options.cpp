@@ -0,0 +1,172 @@
+#include "options.h"
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+
+Options::Options()
+{
+    capture_path = "capture.y4m";
+    capture_on_start = false;
+
+    heights_region[0] = heights_region[1] = -50.f;
+    heights_region[2] = heights_region[3] = 50.f;
+    heights_nx = heights_nz = 256;
+
+    grid_extent = DIM;
+    grid_spacing = UNIT;
+    normalmap_size = TEXSIZE;
+
+    sweep_output = "sweep";
+
+    software = false;
+    compare_software = false;
+    check_grid = false;
+    frames = 600;
+    width = 1280;
+    height = 720;
+    threads = 0;
+    seed = 0;
+    has_seed = false;
+}
+
+GridSettings Options::grid() const
+{
+    GridSettings grid;
+    grid.extent = grid_extent;
+    grid.spacing = grid_spacing;
+    grid.texsize = normalmap_size;
+    return grid;
+}
+
+void Options::parse(const QCoreApplication &app)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Gerstner wave water surface");
+    parser.addHelpOption();
+
+    QCommandLineOption capture("capture",
+            "Record every frame into <file> from startup. A .y4m suffix writes "
+            "YUV4MPEG2, anything else raw rgb24. F9 toggles recording.", "file");
+    parser.addOption(capture);
+
+    QCommandLineOption heights("heights",
+            "Stream the displaced surface of every timestep into <file> as a "
+            "quantized height field series.", "file");
+    QCommandLineOption region("heights-region",
+            "Sampled region of the height field, default -50,-50,50,50.", "x0,z0,x1,z1");
+    QCommandLineOption resolution("heights-resolution",
+            "Height field samples along x and z, default 256x256.", "NXxNZ");
+    parser.addOption(heights);
+    parser.addOption(region);
+    parser.addOption(resolution);
+
+    QCommandLineOption shaders("shader-dir",
+            "Load the shaders from <dir> instead of the built-in copies and "
+            "reload them whenever a file changes. Disables the binary cache.", "dir");
+    parser.addOption(shaders);
+
+    QCommandLineOption grid_size("grid-size",
+            "Edge length of the square surface mesh, default 300.", "units");
+    QCommandLineOption grid_spacing_opt("grid-spacing",
+            "Distance between surface mesh vertices, default 1.", "units");
+    QCommandLineOption normalmap("normalmap-size",
+            "Normal map size, a power of two, default 256.", "texels");
+    parser.addOption(grid_size);
+    parser.addOption(grid_spacing_opt);
+    parser.addOption(normalmap);
+
+    QCommandLineOption benchmark("benchmark",
+            "Play back the camera path in <file> with fixed seeds and simulated "
+            "time, print frame time statistics as JSON and exit with 1 if a "
+            "budget is exceeded.", "file");
+    QCommandLineOption report("benchmark-report",
+            "Also write the benchmark report to <file>.", "file");
+    QCommandLineOption record("record-camera",
+            "Record the interactive camera path into <file> on exit, for use "
+            "with --benchmark.", "file");
+    parser.addOption(benchmark);
+    parser.addOption(report);
+    parser.addOption(record);
+
+    QCommandLineOption sweep("sweep",
+            "Render every wave parameter set and seed in <file> into an offscreen "
+            "atlas, write one image per variant and exit.", "file");
+    QCommandLineOption sweep_output_opt("sweep-output",
+            "Directory for the --sweep images, default sweep.", "dir");
+    parser.addOption(sweep);
+    parser.addOption(sweep_output_opt);
+
+    QCommandLineOption soft("software",
+            "Render without a window or GPU on all cores and exit. Combine with "
+            "--capture to keep the frames or --benchmark to time them.");
+    QCommandLineOption frames_opt("frames",
+            "Frames to render with --software, default 600.", "n");
+    QCommandLineOption size("size",
+            "Frame size with --software, default 1280x720.", "WxH");
+    QCommandLineOption seed_opt("seed",
+            "Random seed of the waves with --software.", "n");
+    QCommandLineOption threads_opt("threads",
+            "Worker threads with --software, default one per core.", "n");
+    parser.addOption(soft);
+    parser.addOption(frames_opt);
+    parser.addOption(size);
+    parser.addOption(seed_opt);
+    parser.addOption(threads_opt);
+
+    QCommandLineOption check_grid_opt("check-grid",
+            "Compare the height field grid evaluator with per-point evaluation "
+            "over --heights-region at --heights-resolution, print the errors "
+            "and timings as JSON and exit with 1 if out of tolerance.");
+    parser.addOption(check_grid_opt);
+
+    QCommandLineOption compare_opt("compare-software",
+            "Render one frame of the --seed waves at --size on the GPU and with "
+            "the software renderer, print PSNR and differences as JSON and exit "
+            "with 1 if they are out of tolerance.");
+    parser.addOption(compare_opt);
+
+    parser.process(app);
+
+    if (parser.isSet(capture)) {
+        capture_path = parser.value(capture);
+        capture_on_start = true;
+    }
+
+    if (parser.isSet(heights)) heights_path = parser.value(heights);
+    if (parser.isSet(region)) {
+        QStringList v = parser.value(region).split(",");
+        if (v.size() != 4) parser.showHelp(1);
+        for (int i = 0; i < 4; i++) heights_region[i] = v[i].toFloat();
+    }
+    if (parser.isSet(resolution)) {
+        QStringList v = parser.value(resolution).split("x");
+        heights_nx = v[0].toInt();
+        heights_nz = v.size() > 1 ? v[1].toInt() : heights_nx;
+    }
+
+    if (parser.isSet(shaders)) shader_dir = parser.value(shaders);
+    if (parser.isSet(grid_size)) grid_extent = parser.value(grid_size).toFloat();
+    if (parser.isSet(grid_spacing_opt)) grid_spacing = parser.value(grid_spacing_opt).toFloat();
+    if (parser.isSet(normalmap)) normalmap_size = parser.value(normalmap).toInt();
+    if (parser.isSet(benchmark)) benchmark_path = parser.value(benchmark);
+    if (parser.isSet(report)) benchmark_report = parser.value(report);
+    if (parser.isSet(record)) record_camera_path = parser.value(record);
+    if (parser.isSet(sweep)) sweep_path = parser.value(sweep);
+    if (parser.isSet(sweep_output_opt)) sweep_output = parser.value(sweep_output_opt);
+
+    software = parser.isSet(soft);
+    check_grid = parser.isSet(check_grid_opt);
+    compare_software = parser.isSet(compare_opt);
+    if (parser.isSet(frames_opt)) frames = parser.value(frames_opt).toInt();
+    if (parser.isSet(size)) {
+        QStringList v = parser.value(size).split("x");
+        if (v.size() != 2) parser.showHelp(1);
+        width = v[0].toInt();
+        height = v[1].toInt();
+    }
+    if (parser.isSet(seed_opt)) {
+        seed = parser.value(seed_opt).toUInt();
+        has_seed = true;
+    }
+    if (parser.isSet(threads_opt)) threads = parser.value(threads_opt).toInt();
+}
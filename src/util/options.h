@@ -0,0 +1,41 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <QString>
+#include "waveset.h"
+
+class QCoreApplication;
+
+// Command line settings shared by the windowed and offline modes
+struct Options
+{
+    Options();
+    void parse(const QCoreApplication &app);
+
+    QString capture_path; // file to record frames into (.y4m or raw rgb24)
+    bool capture_on_start;
+
+    QString heights_path; // height field time series to stream to, if any
+    float heights_region[4]; // x0, z0, x1, z1
+    int heights_nx, heights_nz;
+
+    QString shader_dir; // load shaders from here and reload them on change
+
+    float grid_extent, grid_spacing; // base mesh, see GridSettings
+    int normalmap_size;
+    GridSettings grid() const;
+
+    QString benchmark_path, benchmark_report;
+    QString record_camera_path; // camera path to write on exit, if any
+
+    QString sweep_path, sweep_output; // see ParameterSweep
+
+    bool software; // render offline on the CPU, see SoftRenderer
+    bool compare_software; // render with both paths and compare, see softcompare.h
+    bool check_grid; // compare the height field grid evaluator, see gridcheck.h
+    int frames, width, height, threads;
+    unsigned int seed;
+    bool has_seed;
+};
+
+#endif // OPTIONS_H
@@ -1,4 +1,4 @@
-QT += core gui opengl
+QT += core gui opengl concurrent
 
 TARGET = water-surface
 TEMPLATE = app
@@ -12,17 +12,70 @@ QMAKE_CFLAGS -= -O2
 QMAKE_CXXFLAGS += -O3
 QMAKE_CXXFLAGS -= -O2
 
-DEPENDPATH += src src/ui src/util src/engine
-INCLUDEPATH += src src/ui src/util src/engine
+DEPENDPATH += src src/ui src/util src/engine src/capture src/export src/bench src/soft
+INCLUDEPATH += src src/ui src/util src/engine src/capture src/export src/bench src/soft
 
 SOURCES += main.cpp \
            src/ui/mainwindow.cpp \
            src/ui/glwidget.cpp \
+           src/ui/parameterpanel.cpp \
            src/util/camera.cpp \
-           src/engine/waterengine.cpp
+           src/util/options.cpp \
+           src/engine/waterengine.cpp \
+           src/engine/waterresources.cpp \
+           src/engine/waveset.cpp \
+           src/engine/wavefunction.cpp \
+           src/engine/wavespectrum.cpp \
+           src/engine/shadercache.cpp \
+           src/engine/glresources.cpp \
+           src/engine/offscreentarget.cpp \
+           src/capture/framecapture.cpp \
+           src/capture/frameencoder.cpp \
+           src/export/heightfieldwriter.cpp \
+           src/export/heightfieldreader.cpp \
+           src/bench/benchmark.cpp \
+           src/bench/camerapath.cpp \
+           src/bench/gputimer.cpp \
+           src/bench/parametersweep.cpp \
+           src/bench/sweeprunner.cpp \
+           src/bench/gridcheck.cpp \
+           src/soft/softrenderer.cpp \
+           src/soft/softrunner.cpp \
+           src/soft/softcompare.cpp
 
 HEADERS += src/ui/mainwindow.h \
            src/ui/glwidget.h \
+           src/ui/parameterpanel.h \
            src/util/camera.h \
            src/util/vector.h \
-           src/engine/waterengine.h
+           src/util/matrix.h \
+           src/util/options.h \
+           src/engine/waterengine.h \
+           src/engine/waterresources.h \
+           src/engine/waveset.h \
+           src/engine/wavefunction.h \
+           src/engine/wavespectrum.h \
+           src/engine/shadercache.h \
+           src/engine/glresources.h \
+           src/engine/offscreentarget.h \
+           src/capture/framecapture.h \
+           src/capture/frameencoder.h \
+           src/export/heightfieldformat.h \
+           src/export/heightfieldwriter.h \
+           src/export/heightfieldreader.h \
+           src/bench/benchmark.h \
+           src/bench/camerapath.h \
+           src/bench/gputimer.h \
+           src/bench/parametersweep.h \
+           src/bench/sweeprunner.h \
+           src/bench/gridcheck.h \
+           src/soft/simd.h \
+           src/soft/softrenderer.h \
+           src/soft/softrunner.h \
+           src/soft/softcompare.h
+
+RESOURCES += shaders.qrc
+
+OTHER_FILES += shaders/normalmap.frag \
+               shaders/wave.vert \
+               shaders/wave.frag